@@ -146,6 +146,34 @@ void my_cb_function(unsigned int characteristic, int value, unsigned int dir, vo
   }
 }
 
+/**
+ * Called by the SDK as soon as the Nuimo is connected and all notifications are armed.
+ * To install this function use ::nuimo_init_ready_function
+ *
+ * @param user_data Pointer to user data. Not used in the example
+ */
+void my_ready_function(void *user_data) {
+  struct nuimo_stats_s stats;
+
+  DEBUG_PRINT(("my_ready_function\n"));
+
+  nuimo_get_stats(&stats);
+  printf("Nuimo ready after %lld ms\n", (long long) stats.ready_time / 1000);
+}
+
+/**
+ * Handler registered with ::nuimo_add_handler for button presses only. Unlike my_cb_function()
+ * it needs no switch on the characteristic or the direction.
+ *
+ * @param event     The event
+ * @param user_data Pointer to user data. Not used in the example
+ */
+void my_press_handler(const nuimo_event *event, void *user_data) {
+  DEBUG_PRINT(("my_press_handler\n"));
+
+  printf("Button pressed (event #%llu)\n", (unsigned long long) event->sequence);
+}
+
 /**
  * Default main function. It ignores any given parameter.
  * To initialize, use and close the connection to the Nuimo please follow the
@@ -160,7 +188,17 @@ int main (int argc, char **argv) {
   nuimo_init_status();
   // Additionaly you can add a filter:
   // nuimo_init_search("Address", "DB:3B:2B:xx:xx:xx");
+  // nuimo_init_adapter("hci1");  // Use this BT-Adapter instead of the least loaded one
+  // nuimo_init_bus_mode(NUIMO_BUS_DIRECT);  // Fewer wakeups in crowded BLE environments
+  // nuimo_set_persistent(TRUE);  // Keep the last LED frame on the display
+  // nuimo_load_bindings_file("nuimo.bindings");  // Map events to actions, see nuimo_init_action_function
+  // Or subscribe only the characteristics you need to save wakeups and radio airtime:
+  // nuimo_set_subscription(NUIMO_MASK(NUIMO_BUTTON) | NUIMO_MASK(NUIMO_ROTATION) | NUIMO_MASK(NUIMO_BATTERY));
   nuimo_init_cb_function(my_cb_function, NULL);
+  nuimo_init_ready_function(my_ready_function, NULL);
+  nuimo_add_handler(NUIMO_BUTTON, NUIMO_BUTTON_PRESS, my_press_handler, NULL);
+  // Let the SDK show a volume ring (0...100) while rotating; read it with nuimo_get_widget_value(NUIMO_ROTATION)
+  // nuimo_bind_widget(NUIMO_ROTATION, NUIMO_WIDGET_RING, 0, 100, 50, 20);
   nuimo_init_bt();  // Not much will happen until the g_main_loop is started
 
   loop = g_main_loop_new(NULL, FALSE);
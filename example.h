@@ -7,4 +7,6 @@
 
 void bmp_to_array(const unsigned char *bmp, unsigned char *array);
 void my_cb_function(unsigned int chr, int value, unsigned int dir, void *user_data);
+void my_ready_function(void *user_data);
+void my_press_handler(const nuimo_event *event, void *user_data);
 int  main (int argc, char **argv);
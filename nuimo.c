@@ -1,11 +1,159 @@
 #include "nuimo.h"
 
+/**
+ * @defgroup NUIMO_TRACE Static tracepoints
+ * USDT probes of the provider "nuimo" for bpftrace/perf (see tracing/). A probe is a single nop
+ * as long as no tracer is attached. Without <sys/sdt.h> or with -DNUIMO_NO_TRACE they vanish.
+ * @{
+ */
+#if !defined(NUIMO_NO_TRACE) && defined(__has_include)
+# if __has_include(<sys/sdt.h>)
+#  include <sys/sdt.h>
+#  define NUIMO_TRACE_ENABLED
+# endif
+#endif
+
+#ifdef NUIMO_TRACE_ENABLED
+# define NUIMO_TRACE1(name, a)          DTRACE_PROBE1(nuimo, name, a)
+# define NUIMO_TRACE2(name, a, b)       DTRACE_PROBE2(nuimo, name, a, b)
+# define NUIMO_TRACE3(name, a, b, c)    DTRACE_PROBE3(nuimo, name, a, b, c)
+# define NUIMO_TRACE4(name, a, b, c, d) DTRACE_PROBE4(nuimo, name, a, b, c, d)
+#else
+# define NUIMO_TRACE1(name, a)          do { (void) (a); } while (0)
+# define NUIMO_TRACE2(name, a, b)       do { (void) (a); (void) (b); } while (0)
+# define NUIMO_TRACE3(name, a, b, c)    do { (void) (a); (void) (b); (void) (c); } while (0)
+# define NUIMO_TRACE4(name, a, b, c, d) do { (void) (a); (void) (b); (void) (c); (void) (d); } while (0)
+#endif
+/** @} */
+
+/**
+ * @defgroup NUIMO_WATCHDOG_TIMES Timing of the watchdog in milliseconds
+ * @{
+ */
+#define NUIMO_WATCHDOG_TICK  1000   /// Interval of the watchdog timer
+#define NUIMO_PROBE_TIMEOUT  5000   /// Time a probe read may take before the Nuimo gets reconnected
+#define NUIMO_READY_TIMEOUT  30000  /// Time connecting or re-arming may take before the Nuimo gets reconnected
+#define NUIMO_BACKOFF_BASE   1000   /// Delay of the first reconnect
+#define NUIMO_BACKOFF_MAX    60000  /// Maximum delay between two reconnects
+/** @} */
+
+#define NUIMO_SETTLE_TIME    1000   /// Time in ms the other adapters get to report a discovered Nuimo
+
+/**
+ * @defgroup NUIMO_REFRESH_TIMES Refresh of the persistent LED frame
+ * The tests build the SDK with shorter times to cover several refreshes within seconds.
+ * @{
+ */
+#ifndef NUIMO_PERSISTENT_TIMEOUT
+#define NUIMO_PERSISTENT_TIMEOUT 255  /// Timeout byte of persistent frames (25.5 seconds, the maximum)
+#endif
+#ifndef NUIMO_REFRESH_LEAD
+#define NUIMO_REFRESH_LEAD   1000     /// Time in ms the refresh is written before the frame lapses
+#endif
+#ifndef NUIMO_REFRESH_SPREAD
+#define NUIMO_REFRESH_SPREAD 2000     /// Range in ms the refreshes of different devices are spread over
+#endif
+/** @} */
+
 // prototypes for private functions
+struct handler_list_s;
+struct binding_table_s;
 static void cb_change_val_notify (GDBusProxy *proxy, GVariant *changed_properties, GStrv invalidated_properties, gpointer user_data);
 static void connect_nuimo (GDBusObjectManager *manager, GDBusObject *object);
+static int  object_adapter (GDBusObject *object);
+static gboolean start_settle ();
+static gboolean cb_settle (gpointer user_data);
+static void cb_settle_objects (GObject *source, GAsyncResult *res, gpointer user_data);
 static void get_characteristics(GDBusObjectManager *manager, GDBusObject *object);
 static void cb_object_added (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data);
 static void cb_object_removed (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data);
+static void cb_manager_properties_changed (GDBusObjectManager *manager, GDBusObject *object, GDBusProxy *interface, GVariant *changed, GStrv invalidated, gpointer user_data);
+static void state_write_begin ();
+static void state_write_end ();
+static void state_reset (unsigned int connected);
+static gboolean cb_dispatch_events (gpointer user_data);
+static gboolean is_continuous (const nuimo_event *event);
+static void queue_event (const nuimo_event *event);
+static void queue_connection_event (unsigned int direction);
+static void subscribe_characteristic (unsigned int characteristic);
+static void unsubscribe_characteristic (unsigned int characteristic);
+static void cb_connect_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static void cb_start_notify_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static void cb_call_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static void check_ready ();
+static gboolean is_my_nuimo (GDBusProxy *proxy);
+static int  write_led (const unsigned char *pattern);
+static void teardown_call (GDBusProxy *proxy, const char *method, unsigned int step, unsigned int deadline, GCancellable *cancellable);
+static void cb_teardown_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static gboolean cb_teardown_deadline (gpointer user_data);
+static GVariant *led_variant (const unsigned char *pattern);
+static void led_pattern (unsigned char *pattern, const unsigned char *bitmap, unsigned char brightness, unsigned char timeout, unsigned char mode);
+static void icon_pattern (unsigned char *pattern, unsigned char icon, unsigned char brightness, unsigned char timeout, unsigned char mode);
+static int  call_async (unsigned int characteristic, const char *method, GVariant *parameters, nuimo_done_function done, void *user_data);
+static void cb_async_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static void set_pixel (unsigned char *bitmap, unsigned int row, unsigned int col);
+static void render_widget (unsigned int characteristic, unsigned char *bitmap);
+static void update_widget (unsigned int characteristic, int number, unsigned int direction, gint64 timestamp);
+static void show_widget (unsigned int characteristic, gint64 timestamp);
+static void write_widget_frame ();
+static void cb_widget_write_done (GObject *source, GAsyncResult *res, gpointer user_data);
+static gboolean persist_frame (unsigned char *pattern);
+static void schedule_refresh (guint delay);
+static gboolean cb_refresh_frame (gpointer user_data);
+static int  skip_async (nuimo_done_function done, void *user_data);
+static gboolean cb_async_skipped (gpointer user_data);
+static void set_health (unsigned int health);
+static void record_write_latency (gint64 latency);
+static void start_watchdog ();
+static void stop_watchdog ();
+static void schedule_reconnect ();
+static void start_probe ();
+static void resubscribe ();
+static void cb_probe_done (int result, const unsigned char *data, unsigned int len, void *user_data);
+static gboolean cb_watchdog (gpointer user_data);
+static void dispatch_handlers (const nuimo_event *event);
+static void publish_handlers (unsigned int characteristic, struct handler_list_s *list);
+static void free_retired_handlers ();
+static void dispatch_binding (const nuimo_event *event);
+static int  find_name (const char * const *names, unsigned int len, const char *name);
+static struct binding_table_s *compile_bindings (const char *config);
+static int  find_adapter (const gchar *path);
+static int  device_adapter (GDBusProxy *device);
+static gboolean adapter_allowed (unsigned int adapter);
+static void adapter_loads (GList *objects);
+static GDBusObject *select_nuimo (GList *objects);
+static void stop_discovery ();
+static void connect_device (const gchar *path, int adapter, GDBusProxy *proxy);
+static void add_characteristic (const gchar *path, const gchar *uuid, GDBusProxy *proxy);
+static gboolean match_nuimo (GVariant *name, GVariant *value);
+static gboolean is_my_nuimo_props (GVariant *properties);
+static int  add_adapter (const gchar *path, GDBusProxy *proxy);
+static int  check_adapters ();
+static void connect_value_signal (unsigned int characteristic);
+static void disconnect_value_signal (unsigned int characteristic);
+static GDBusProxy *new_proxy (const gchar *path, const gchar *interface);
+static GVariant *get_managed_objects ();
+static void adapter_loads_direct (GVariant *objects);
+static const gchar *select_nuimo_direct (GVariant *objects, int *adapter);
+static void get_characteristics_direct (const gchar *path, GVariant *interfaces);
+static void remember_characteristic (const gchar *path, const gchar *uuid);
+static int  init_bt_direct ();
+static void subscribe_direct ();
+static int  setup_direct (GVariant *objects);
+static int  setup_manager ();
+static void start_discovery ();
+static void init_done (void *call, int result, gboolean cancelled);
+static void cb_manager_ready (GObject *source, GAsyncResult *res, gpointer user_data);
+static void cb_bus_ready (GObject *source, GAsyncResult *res, gpointer user_data);
+static void cb_owner_ready (GObject *source, GAsyncResult *res, gpointer user_data);
+static void cb_objects_ready (GObject *source, GAsyncResult *res, gpointer user_data);
+static void restart ();
+static unsigned int teardown (unsigned int deadline, gboolean wait);
+static void free_status ();
+static void renew_cancellable ();
+static void cb_properties_changed (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data);
+static void cb_interfaces_added (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data);
+static void cb_interfaces_removed (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data);
 
 
 /**
@@ -24,6 +172,38 @@ const char NUIMO_UUID[NUIMO_ENTRIES_LEN][37] = {
 };
 
 
+/**
+ * Names of the characteristics used in binding configs. The order must be the same like in
+ * ::nuimo_chars_e; NULL if the characteristic can not be bound.
+ */
+static const char * const NUIMO_CHAR_NAMES[NUIMO_ENTRIES_LEN] = {
+  NULL,          /// BT_ADAPTER
+  "CONNECTION",  /// NUIMO (connection state events)
+  "BATTERY",     /// NUIMO_BATTERY
+  NULL,          /// NUIMO_LED
+  "BUTTON",      /// NUIMO_BUTTON
+  "FLY",         /// NUIMO_FLY
+  "SWIPE",       /// NUIMO_SWIPE
+  "ROTATION"     /// NUIMO_ROTATION
+};
+
+
+/**
+ * Names of the directions used in binding configs, indexed by characteristic and direction
+ * (see \ref NUIMO_DIRECTIONS); NULL if the direction does not exist.
+ */
+static const char * const NUIMO_DIRECTION_NAMES[NUIMO_ENTRIES_LEN][NUIMO_BINDING_DIRECTIONS] = {
+  [NUIMO]          = {"LOST", "READY"},
+  [NUIMO_BATTERY]  = {"LEVEL"},
+  [NUIMO_BUTTON]   = {"RELEASE", "PRESS"},
+  [NUIMO_FLY]      = {"LEFT", "RIGHT", NULL, NULL, "UPDOWN"},
+  [NUIMO_SWIPE]    = {"LEFT", "RIGHT", "UP", "DOWN",
+		      "TOUCH_LEFT", "TOUCH_RIGHT", "TOUCH_TOP", "TOUCH_BOTTOM",
+		      "LONG_TOUCH_LEFT", "LONG_TOUCH_RIGHT", "LONG_TOUCH_TOP", "LONG_TOUCH_BOTTOM"},
+  [NUIMO_ROTATION] = {"LEFT", "RIGHT"}
+};
+
+
 /**
  * Structure used to manage the individual Characteristics and devices (BT-Adapter and the Nuimo itself).
  * The structure will be used in the ::nuimo_status_s only.
@@ -34,10 +214,94 @@ typedef struct {
   char       *path;
   gboolean    connected;
   GDBusProxy *proxy;
-  gulong      char_sig_hdl;
+  gulong      char_sig_hdl;  /// Signal handler; in NUIMO_BUS_DIRECT mode the subscription id
+  gboolean    notifying;
 }characteristic_s;
 
 
+/**
+ * Structure holding the value and the range of a LED widget (see \ref NUIMO_WIDGETS).
+ * The structure will be used in the ::nuimo_status_s only.
+ *
+ * \warning This is private stuff. No need to access from the user!
+ */
+typedef struct {
+  unsigned int type;       /// The widget type based on ::nuimo_widget
+  int          min;        /// Lower limit of the value
+  int          max;        /// Upper limit of the value
+  int          value;      /// Current value; read it with ::nuimo_get_widget_value
+  int          step;       /// Change of the value per swipe; rotation units per value for the rotation
+  int          remainder;  /// Rotation not yet applied to the value
+}widget_s;
+
+
+/**
+ * Registered handler (see ::nuimo_add_handler)
+ */
+typedef struct {
+  unsigned int           id;         /// Id returned by nuimo_add_handler
+  unsigned int           direction;  /// Direction filter or NUIMO_DIRECTION_ANY
+  nuimo_handler_function function;   /// Function to call
+  void                  *user_data;  /// Pointer to userdata for the function
+}handler_s;
+
+
+/**
+ * Immutable list of the handlers of one characteristic. Changes build a new list and swap the
+ * pointer; the old list is freed once no dispatch is running anymore.
+ */
+typedef struct handler_list_s {
+  unsigned int count;      /// Number of handlers
+  handler_s    handler[];  /// The handlers in order of registration
+}handler_list_s;
+
+
+/**
+ * One entry of the binding table (see ::nuimo_load_bindings)
+ */
+typedef struct {
+  const char *action;    /// Name of the action; NULL if nothing is bound
+  int         argument;  /// Argument handed over to the action function
+}binding_s;
+
+
+/**
+ * Compiled binding table. It is allocated as one block incl. the action names and never changed;
+ * a new config builds a new table and swaps the pointer.
+ */
+typedef struct binding_table_s {
+  binding_s binding[NUIMO_ENTRIES_LEN][NUIMO_BINDING_DIRECTIONS][2];  /// Indexed by characteristic, direction and button held
+  char      names[];                                                  /// The action names
+}binding_table_s;
+
+
+/**
+ * A BT-Adapter. The entries are kept over reconnects to keep the counters.
+ */
+typedef struct {
+  char       *path;         /// D-Bus path of the adapter
+  GDBusProxy *proxy;        /// Proxy of the adapter; NULL if not present
+  gboolean    discovering;  /// TRUE after StartDiscovery
+  guint64     events;       /// Events received through this adapter
+  guint64     writes;       /// LED writes sent through this adapter
+  guint       devices;      /// Connected devices other than the Nuimo as of the last lookup of the objects
+}adapter_s;
+
+
+/**
+ * Holds the user function of an asynchronous call until the call completes
+ *
+ * \warning This is private stuff. No need to access from the user!
+ */
+typedef struct {
+  nuimo_done_function done;            /// Function to call on completion
+  void               *user_data;       /// Pointer to userdata for the done function
+  unsigned int        characteristic;  /// The characteristic of the call
+  gint64              start;           /// Time the call was issued
+  guint64             id;              /// Id of the LED write for the tracepoints
+}async_call_s;
+
+
 /**
  * Defines the structure of the structure that holds all required information about 
  * the BT-Adapter, the Nuimo and its characteristics.
@@ -47,13 +311,76 @@ typedef struct {
 struct nuimo_status_s {
   char               *keyword;                           /// Used for search a specific Nuimo (e.g. "Address")
   char               *value;                             /// Used for search a specific Nuimo (e.g. "xx:xx:xx:xx:xx:xx")
-  gulong              object_added_sig_hdl;              /// Holds the handler for 'BT found new device' events
-  gulong              object_removed_sig_hdl;            /// Holds the handler for 'BT lost a conneted device'
+  gulong              object_added_sig_hdl;              /// Holds the handler for 'BT found new device' events (subscription id in direct mode)
+  gulong              object_removed_sig_hdl;            /// Holds the handler for 'BT lost a conneted device' (subscription id in direct mode)
+  gulong              wakeup_sig_hdl;                    /// Holds the handler counting the property changes of all objects (manager mode)
   GDBusObjectManager *manager;                           /// GDbus manager.
   gboolean            active_discovery;                  /// Just to remember that the code started a discovery
+  gboolean            settling;                          /// TRUE from the first report of the Nuimo by discovery until it gets connected
+  guint               settle_src;                        /// Timer of ::cb_settle
   void              (*cb_function)(unsigned int, int, unsigned int, void*);     /// This is the pointer to the user callback function
   void               *user_data;                         /// Pointer to userdata. Can be a pointer to a struct.
+  nuimo_batch_function batch_function;                   /// Pointer to the user batch callback function
+  void               *batch_user_data;                   /// Pointer to userdata for the batch callback function
+  GArray             *events;                            /// Events received in the current main loop iteration
+  GArray             *batch;                             /// Events currently handed over to the user
+  guint               dispatch_src;                      /// Idle source delivering the collected events (0 if none pending)
+  GArray             *continuous;                        /// Lane of the continuous events (rotation, fly up/down, battery); merged while waiting
+  int                 continuous_slot[NUIMO_ENTRIES_LEN]; /// Index of the pending continuous event of each characteristic; -1 if none
+  guint64             event_seq;                         /// Sequence number of the last event
+  unsigned int        subscription;                      /// Mask of the characteristics to subscribe (see \ref NUIMO_MASKS)
+  struct nuimo_stats_s stats;                            /// Load counters
+  GCancellable       *cancellable;                       /// Cancels all pending asynchronous calls on disconnect
+  gboolean            connecting;                        /// TRUE while the Connect call is pending
+  gboolean            ready;                             /// TRUE once the Nuimo is connected and all notifications are armed
+  gboolean            announced;                         /// TRUE once READY was reported for the current connection
+  gint64              connect_start;                     /// Time the Connect call (or the re-arming) was issued; 0 if none
+  nuimo_ready_function ready_function;                   /// Pointer to the user ready function
+  void               *ready_user_data;                   /// Pointer to userdata for the ready function
+  widget_s            widget[NUIMO_ENTRIES_LEN];         /// The LED widgets bound to the characteristics
+  unsigned char       widget_frame[13];                  /// Latest widget frame incl. brightness and timeout
+  gboolean            widget_busy;                       /// TRUE while a widget LED write is pending
+  gboolean            widget_dirty;                      /// TRUE if widget_frame was not written yet
+  gint64              widget_input;                      /// Arrival time of the input rendered into widget_frame
+  gint64              widget_written;                    /// Arrival time of the input of the pending write
+  gint64              widget_start;                      /// Time the pending write was issued
+  guint64             widget_write_id;                   /// Id of the pending write for the tracepoints
+  guint64             led_write_id;                      /// Last id given to a LED write
+  gboolean            persistent;                        /// TRUE if the library keeps the last frame on the display
+  unsigned char       persistent_frame[13];              /// Last frame written by the user; timeout byte is 0 if none
+  gint64              frame_expiry;                      /// Time the persistent frame lapses on the display; 0 if not shown
+  guint               refresh_src;                       /// Timer of the next refresh (0 if none)
+  unsigned int        teardown_pending;                  /// Number of teardown calls waiting for their reply
+  unsigned int        teardown_failed;                   /// Teardown steps which failed or were abandoned (see \ref NUIMO_TEARDOWN)
+  handler_list_s     *handlers[NUIMO_ENTRIES_LEN];       /// Current handler list of each characteristic
+  GSList             *handlers_retired;                  /// Replaced handler lists and binding tables waiting to be freed
+  unsigned int        handler_id;                        /// Last id given to a handler
+  unsigned int        dispatch_depth;                    /// Number of running dispatches (handlers may dispatch again)
+  binding_table_s    *bindings;                          /// Current binding table; NULL if none is loaded
+  nuimo_action_function action_function;                 /// Pointer to the user action function
+  void               *action_user_data;                  /// Pointer to userdata for the action function
+  adapter_s           adapter[NUIMO_ADAPTERS_MAX];       /// All known BT-Adapters
+  unsigned int        adapters;                          /// Number of entries in adapter
+  unsigned int        adapter_used;                      /// Index of the adapter the Nuimo is connected through
+  char               *adapter_pin;                       /// Adapter set by nuimo_init_adapter; NULL for automatic placement
+  unsigned int        bus_mode;                          /// Based on ::nuimo_bus_mode
+  GDBusConnection    *connection;                        /// The system bus in NUIMO_BUS_DIRECT mode
+  gchar              *bus_owner;                         /// Unique bus name of BlueZ in NUIMO_BUS_DIRECT mode; proxies need no name lookup
+  unsigned int        health;                            /// Link health based on ::nuimo_health
+  nuimo_health_function health_function;                 /// Pointer to the user health function
+  void               *health_user_data;                  /// Pointer to userdata for the health function
+  unsigned int        watchdog_silence;                  /// Max. time in ms without notification; 0 disables the watchdog
+  unsigned int        watchdog_write;                    /// Max. average LED write latency in ms; 0 disables the check
+  guint               watchdog_src;                      /// The watchdog timer
+  gint64              last_notify;                       /// Arrival time of the last notification
+  gint64              probe_start;                       /// Time the pending probe read was issued
+  gboolean            reconnecting;                      /// TRUE while the watchdog reconnects the Nuimo
+  gboolean            restarting;                        /// TRUE while the SDK itself tears the connection down for a reconnect
+  gint64              reconnect_at;                      /// Time of the next reconnect attempt
+  unsigned int        reconnect_attempts;                /// Number of reconnects since the Nuimo was ready the last time
   characteristic_s    characteristic[NUIMO_ENTRIES_LEN]; /// An array of structs to manage all required information for each characteristic and devices
+  guint               state_seq;                         /// Seqlock sequence of the state block. Odd while the state gets updated
+  struct nuimo_state_s state;                            /// Current state of the Nuimo. Read it with ::nuimo_get_state only
 };
 
 
@@ -77,17 +404,26 @@ static void cb_change_val_notify (GDBusProxy *proxy, GVariant *changed_propertie
   gsize        len;
   gint16       number;
   unsigned int direction = 0;
+  nuimo_event  event;
 
   DEBUG_PRINT(("cb_change_val_notify\n"));
 
+  event.timestamp = g_get_monotonic_time();
+  my_nuimo->stats.notifications++;
+  NUIMO_TRACE2(notify__arrival, GPOINTER_TO_INT(user_data), event.timestamp);
+
 
   // Check if te Nuimo just got disconnected
   if (GPOINTER_TO_INT(user_data) == NUIMO) {
     v2 = g_variant_lookup_value(changed_properties, "Connected", NULL);
     if (v2 && !g_variant_get_boolean(v2)) {
+      g_variant_unref(v2);
       // Do the hard way: remove everything and start from the beginning
-      nuimo_disconnect();
-      nuimo_init_bt();
+      restart();
+      return;
+    }
+    if (v2) {
+      g_variant_unref(v2);
     }
   } 
 
@@ -98,466 +434,3974 @@ static void cb_change_val_notify (GDBusProxy *proxy, GVariant *changed_propertie
   }
   value = g_variant_get_fixed_array(v2, &len, 1);
 
+  // Keep track of the notification inter-arrival time for the watchdog
+  if (my_nuimo->last_notify) {
+    my_nuimo->stats.notify_interval = (7 * my_nuimo->stats.notify_interval + event.timestamp - my_nuimo->last_notify) / 8;
+  }
+  my_nuimo->last_notify = event.timestamp;
+
+  if (len < 1 || (len < 2 && (GPOINTER_TO_INT(user_data) == NUIMO_FLY || GPOINTER_TO_INT(user_data) == NUIMO_ROTATION))) {
+    g_variant_unref(v2);
+    return;
+  }
+
+
+  state_write_begin();
 
   switch (GPOINTER_TO_INT(user_data)) {
   case NUIMO_BATTERY :
     number = value[0];
+    my_nuimo->state.battery = number;
     break;
     
   case NUIMO_BUTTON :
+    number    = 0;
+    direction = value[0];
+    my_nuimo->state.button = direction;
+    break;
+
   case NUIMO_SWIPE :
     number    = 0;
     direction = value[0];
+    my_nuimo->state.swipe = direction;
     break;
     
   case NUIMO_FLY :
     number    = value[1];
     direction = value[0];
+    my_nuimo->state.fly       = direction;
+    my_nuimo->state.fly_value = number;
     break;
     
   case NUIMO_ROTATION :
     number    = ((value[1] & 255) << 8) + (value[0] & 255);
     direction = number > 0 ? NUIMO_ROTATION_LEFT : NUIMO_ROTATION_RIGHT;
+    my_nuimo->state.rotation += number;
     break;
     
   default:
     // unexpected call.
     DEBUG_PRINT(("  Unexpected call of cb_change_val_notify!\n"));
+    state_write_end();
+    g_variant_unref(v2);
     return;
   }
 
-  my_nuimo->cb_function(GPOINTER_TO_INT(user_data), number, direction, my_nuimo->user_data);
-}
+  my_nuimo->state.updates++;
+  state_write_end();
 
+  // Queue the event; all events of this main loop iteration are delivered together
+  event.characteristic = GPOINTER_TO_INT(user_data);
+  event.value          = number;
+  event.direction      = direction;
+  event.sequence       = ++my_nuimo->event_seq;
+  event.held           = event.characteristic != NUIMO_BUTTON && my_nuimo->state.button == NUIMO_BUTTON_PRESS;
+  NUIMO_TRACE4(notify__decode, event.characteristic, event.value, event.sequence, event.timestamp);
+  event.raw_len        = MIN(len, NUIMO_EVENT_RAW_LEN);
+  memcpy(event.raw, value, event.raw_len);
+  g_variant_unref(v2);
 
-/**
- * uses the bt_adapter to connect to the Nuimo (after checking that the Nuimo matches the
- * key/value pair if given)
- *
- * @param manager
- * @param object
-*/
-static void connect_nuimo (GDBusObjectManager *manager, GDBusObject *object) {
-  GVariant    *variant = NULL;
-  GList       *if_list, *interfaces;
-  GError      *DBerror;
-  const gchar *path;
-  
-  DEBUG_PRINT(("connect_nuimo\n"));
- 
-  if (!my_nuimo->characteristic[BT_ADAPTER].proxy) {
-    return;
+  // Widgets update the LED matrix directly from here
+  if (my_nuimo->widget[event.characteristic].type != NUIMO_WIDGET_NONE) {
+    update_widget(event.characteristic, number, direction, event.timestamp);
   }
 
-  path       = g_dbus_object_get_object_path(object);
-  interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (object));
-      
-  for (if_list = interfaces; if_list != NULL; if_list = if_list->next) {
+  queue_event(&event);
+  my_nuimo->stats.events++;
+  my_nuimo->adapter[my_nuimo->adapter_used].events++;
+}
 
-    // Search for Nuimo
-    variant = g_dbus_proxy_get_cached_property (if_list->data, "Name");
-    if (variant && !strcmp(NUIMO_NAME, g_variant_get_string(variant, NULL))) {
 
-      // If keyword is set check if the value matches. if not continue
-      if (my_nuimo->keyword) {
-	variant = g_dbus_proxy_get_cached_property (if_list->data, my_nuimo->keyword);
-	if (!variant || strcmp(my_nuimo->value, g_variant_get_string(variant, NULL))) {
-	  continue;
-	}
-      }
-      
-      // Just found the Nuimo I was looking for. So connect to it
-      my_nuimo->characteristic[NUIMO].path = strdup(path);
-
-      my_nuimo->characteristic[NUIMO].proxy = (GDBusProxy*) g_dbus_object_manager_get_interface(manager,
-												my_nuimo->characteristic[NUIMO].path,
-												BT_DEVICE_NAME);
-      DBerror = NULL;
-      g_dbus_proxy_call_sync(my_nuimo->characteristic[NUIMO].proxy,
-			     "Connect",
-			     NULL,
-			     G_DBUS_CALL_FLAGS_NONE,
-			     -1,
-			     NULL,
-			     &DBerror);
-
-      if (DBerror) {
-	fprintf(stderr, "*EE* Error connecting: %s\n", DBerror->message);
-	free(my_nuimo->characteristic[NUIMO].path);
-	my_nuimo->characteristic[NUIMO].path = NULL;
-	g_variant_unref(variant);
-	g_error_free(DBerror);
-	return;
-      }
+/**
+ * Continuous events only report a changed position or level. They can be merged while waiting
+ * for the dispatch without losing information. Fly left/right are gestures and stay discrete.
+ *
+ * @param event The event to classify
+ * @return TRUE for continuous events
+ */
+static gboolean is_continuous (const nuimo_event *event) {
+  switch (event->characteristic) {
+  case NUIMO_ROTATION :
+  case NUIMO_BATTERY :
+    return(TRUE);
 
-      if (my_nuimo->active_discovery) {
-	// As I'm connected now start looking for Characteristics
-	DBerror = NULL;
-	g_dbus_proxy_call_sync( my_nuimo->characteristic[BT_ADAPTER].proxy,
-				"StopDiscovery",
-				NULL,
-				G_DBUS_CALL_FLAGS_NONE,
-				-1,
-				NULL,
-				&DBerror);
+  case NUIMO_FLY :
+    return(event->direction == NUIMO_FLY_UPDOWN);
 
-	if (DBerror) {
-	  fprintf(stderr, "*EE* Error StopDiscovery: %s\n", DBerror->message);
-	  g_variant_unref(variant);
-	  g_error_free(DBerror);
-	  return;
-	}
-	my_nuimo->active_discovery = FALSE;
-      }
+  default:
+    return(FALSE);
+  }
+}
 
-      // Connect to signals from Nuimo; including if it gets disconnected	  
-      my_nuimo->characteristic[NUIMO].char_sig_hdl = g_signal_connect (my_nuimo->characteristic[NUIMO].proxy,
-								       "g-properties-changed",
-								       G_CALLBACK (cb_change_val_notify),
-								       GINT_TO_POINTER(NUIMO));
 
-      // Connect to object-removed signal to see if the Nuimo disappears
-      my_nuimo->object_removed_sig_hdl = g_signal_connect (my_nuimo->manager,
-							   "object-removed",
-							   G_CALLBACK (cb_object_removed),
-							   NULL);
+/**
+ * Queues an event for the next dispatch. Discrete events (button, swipe/touch, fly gestures,
+ * connection state) go to the priority lane. A continuous event is merged into the pending one
+ * of the same characteristic, direction and button state: rotations are summed up, otherwise
+ * the latest value wins. The
+ * merged event keeps the arrival time of the oldest and the sequence and raw payload of the
+ * latest event.
+ *
+ * @param event The event to queue
+ */
+static void queue_event (const nuimo_event *event) {
+  nuimo_event *pending;
+  GSource     *source;
+  int          slot;
+  int          value;
+  gint64       timestamp;
 
+  if (!is_continuous(event)) {
+    g_array_append_val(my_nuimo->events, *event);
+  } else if ((slot = my_nuimo->continuous_slot[event->characteristic]) >= 0 &&
+	     g_array_index(my_nuimo->continuous, nuimo_event, slot).direction == event->direction &&
+	     g_array_index(my_nuimo->continuous, nuimo_event, slot).held == event->held) {
+    pending   = &g_array_index(my_nuimo->continuous, nuimo_event, slot);
+    value     = event->characteristic == NUIMO_ROTATION ? pending->value + event->value : event->value;
+    timestamp = pending->timestamp;
 
-      
-      my_nuimo->characteristic[NUIMO].connected = TRUE;
-      break;
-    }
+    *pending = *event;
+    pending->value     = value;
+    pending->timestamp = timestamp;
+    my_nuimo->stats.merged++;
+  } else {
+    g_array_append_val(my_nuimo->continuous, *event);
+    my_nuimo->continuous_slot[event->characteristic] = my_nuimo->continuous->len - 1;
   }
 
-  if (variant) {
-    g_variant_unref(variant);
+  // Same priority as the D-Bus signals; an idle priority would starve under sustained notify load
+  if (!my_nuimo->dispatch_src) {
+    source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_set_callback(source, cb_dispatch_events, NULL, NULL);
+    my_nuimo->dispatch_src = g_source_attach(source, NULL);
+    g_source_unref(source);
   }
 }
 
 
 /**
- * Gather all characteristics and setup change notification for all of them
+ * Queues a connection state event (characteristic NUIMO) in the priority lane
  *
- * @param manager
- * @param object
+ * @param direction NUIMO_CONNECTION_READY or NUIMO_CONNECTION_LOST
  */
-static void get_characteristics(GDBusObjectManager *manager, GDBusObject *object) {
-  GVariant    *variant = NULL;
-  GList       *if_list, *interfaces;
-  const gchar *path;
+static void queue_connection_event (unsigned int direction) {
+  nuimo_event event;
+
+  event.characteristic = NUIMO;
+  event.value          = 0;
+  event.direction      = direction;
+  event.timestamp      = g_get_monotonic_time();
+  event.sequence       = ++my_nuimo->event_seq;
+  event.held           = FALSE;
+  event.raw_len        = 0;
+
+  queue_event(&event);
+}
+
+
+/**
+ * Delivers the collected events to the user. It runs as idle source of default priority in the
+ * main loop iteration after the first event arrived, so all notifications pending in the
+ * iteration are already decoded and handed over as one batch, also under sustained load.
+ * The old style callback function is called for each event of the batch.
+ *
+ * @param user_data Not used
+ * @return Always FALSE to remove the idle source
+ */
+static gboolean cb_dispatch_events (gpointer user_data) {
+  GArray      *batch;
+  nuimo_event *event;
   unsigned int i;
-  GError      *DBerror;
+  gint64       now;
 
-  DEBUG_PRINT(("get_characteristics\n"));
+  DEBUG_PRINT(("cb_dispatch_events\n"));
 
-  path = g_dbus_object_get_object_path(object);
-  interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (object));
+  my_nuimo->dispatch_src = 0;
 
-  for (if_list = interfaces; if_list != NULL; if_list = if_list->next) {
-    variant = g_dbus_proxy_get_cached_property (if_list->data, "UUID");
+  // Swap the arrays; events arriving during the user callbacks end up in the next batch
+  batch            = my_nuimo->events;
+  my_nuimo->events = my_nuimo->batch;
+  my_nuimo->batch  = batch;
+  my_nuimo->stats.batches++;
 
-    if (variant) {
-      for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
-	if (!my_nuimo->characteristic[i].path && !strcmp(NUIMO_UUID[i], g_variant_get_string(variant, NULL))) {
-
-	  my_nuimo->characteristic[i].path = strdup(path);
-	  
-	  my_nuimo->characteristic[i].proxy = (GDBusProxy*) g_dbus_object_manager_get_interface(my_nuimo->manager,
-												my_nuimo->characteristic[i].path,
-												BT_CHARACTERISTIC_NAME);
-	  DEBUG_PRINT(("UUID = %s\n", NUIMO_UUID[i]));
-
-	  //The LED characteristic has no notify function; skip this 
-	  if (i != NUIMO_LED) {
-
-	    DBerror = NULL;
-	    g_dbus_proxy_call_sync(my_nuimo->characteristic[i].proxy,
-				   "StartNotify",
-				   NULL,
-				   G_DBUS_CALL_FLAGS_NONE,
-				   -1,
-				   NULL,
-				   &DBerror);
-
-	    if(DBerror) {
-	      fprintf(stderr, "*EE* Error StartNotify (UUID: %s): %s\n", NUIMO_UUID[i], DBerror->message);
-	      g_variant_unref(variant);
-	      g_error_free(DBerror);
-	      return;
-	    }
-	    
-	    my_nuimo->characteristic[i].char_sig_hdl = g_signal_connect (my_nuimo->characteristic[i].proxy,
-									 "g-properties-changed",
-									 G_CALLBACK (cb_change_val_notify),
-									 GINT_TO_POINTER(i));
-	  }
+  // The discrete events come first, followed by the merged continuous events
+  g_array_append_vals(batch, my_nuimo->continuous->data, my_nuimo->continuous->len);
+  g_array_set_size(my_nuimo->continuous, 0);
+  for (i = 0; i < NUIMO_ENTRIES_LEN; i++) {
+    my_nuimo->continuous_slot[i] = -1;
+  }
 
-	  break;
-	}
-      }
+  now = g_get_monotonic_time();
+  for (i = 0; i < batch->len; i++) {
+    event = &g_array_index(batch, nuimo_event, i);
+    if (event->characteristic == NUIMO_BUTTON) {
+      my_nuimo->stats.button_latency     = now - event->timestamp;
+      my_nuimo->stats.button_latency_max = MAX(my_nuimo->stats.button_latency_max, my_nuimo->stats.button_latency);
     }
   }
-  
-  if (variant) {
-    g_variant_unref(variant);
+
+  if (batch->len) {
+    event = &g_array_index(batch, nuimo_event, 0);
+    NUIMO_TRACE3(callback__entry, event->sequence, batch->len, event->timestamp);
+  }
+
+  if (my_nuimo->batch_function) {
+    my_nuimo->batch_function((const nuimo_event*) batch->data, batch->len, my_nuimo->batch_user_data);
+  }
+
+  for (i = 0; i < batch->len; i++) {
+    event = &g_array_index(batch, nuimo_event, i);
+    dispatch_handlers(event);
+    dispatch_binding(event);
+    // The old style callback does not know the connection state events
+    if (my_nuimo->cb_function && event->characteristic != NUIMO) {
+      my_nuimo->cb_function(event->characteristic, event->value, event->direction, my_nuimo->user_data);
+    }
+  }
+
+  // Empty batches (possible after the swap of the lanes) fire neither probe, so they stay paired
+  if (batch->len) {
+    NUIMO_TRACE1(callback__exit, batch->len);
   }
+  g_array_set_size(batch, 0);
+
+  return(FALSE);
 }
 
 
 /**
- * Receives a signal in case a object (Nuimo or characteristic) is newly found
- *
- * @param manager
- * @param object
- * @param user_data
+ * Starts an update of the state block. Every call must be followed by ::state_write_end.
+ * Only the GLib main loop writes the state, so there is no need for a writer lock.
  */
-static void cb_object_added (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data) {
-  DEBUG_PRINT(("cb_object_added\n"));
+static void state_write_begin () {
+  __atomic_store_n(&my_nuimo->state_seq, my_nuimo->state_seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
 
-  if (!my_nuimo->characteristic[NUIMO].connected) {
-    connect_nuimo(manager, object);
-  } else {
-    get_characteristics(manager, object);
-  }
+
+/**
+ * Publishes the updated state block to the readers
+ */
+static void state_write_end () {
+  __atomic_store_n(&my_nuimo->state_seq, my_nuimo->state_seq + 1, __ATOMIC_RELEASE);
 }
 
 
 /**
- * Receives a signal in case the Nuimo gets disconnected
- * First all handles must released and thn the search needs to be re-initated
+ * Resets the state block. Used whenever the Nuimo connects or disconnects.
  *
- * @param manager
- * @param object
- * @param user_data
+ * @param connected The new connection state
  */
-static void cb_object_removed (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data) {
-  DEBUG_PRINT(("cb_object_removed\n"));
+static void state_reset (unsigned int connected) {
+  state_write_begin();
+  my_nuimo->state.connected = connected;
+  my_nuimo->state.button    = NUIMO_BUTTON_RELEASE;
+  my_nuimo->state.swipe     = NUIMO_SWIPE_LEN;
+  my_nuimo->state.fly       = NUIMO_FLY_LEN;
+  my_nuimo->state.fly_value = 0;
+  my_nuimo->state.battery   = -1;
+  my_nuimo->state.rotation  = 0;
+  my_nuimo->state.updates   = 0;
+  state_write_end();
+}
 
-  GVariant *variant = NULL;
-  GList    *if_list, *interfaces;
 
-  if (!my_nuimo->characteristic[BT_ADAPTER].proxy) {
+/**
+ * uses the bt_adapter to connect to the Nuimo (after checking that the Nuimo matches the
+ * key/value pair if given). The Connect and StopDiscovery calls are issued asynchronously
+ * and in parallel; ::cb_connect_done continues the setup.
+ *
+ * @param manager
+ * @param object
+*/
+static void connect_nuimo (GDBusObjectManager *manager, GDBusObject *object) {
+  const gchar *path;
+  int          adapter;
+  
+  DEBUG_PRINT(("connect_nuimo\n"));
+ 
+  if (!my_nuimo->adapters) {
     return;
   }
-  
-  // Check if the Nuimo triggered the object-removed event
-  interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (object));
-      
-  for (if_list = interfaces; if_list != NULL; if_list = if_list->next) {
 
-    // Search for Nuimo
-    variant = g_dbus_proxy_get_cached_property (if_list->data, "Name");
-    if (variant && !strcmp(NUIMO_NAME, g_variant_get_string(variant, NULL))) {
-
-      // If keyword is set check if the value matches. if not continue
-      if (my_nuimo->keyword) {
-	variant = g_dbus_proxy_get_cached_property (if_list->data, my_nuimo->keyword);
-	if (!variant || strcmp(my_nuimo->value, g_variant_get_string(variant, NULL))) {
-	  continue;
-	}
-      }
-      // Do the hard way: remove everything and start from the beginning
-      nuimo_disconnect();
-      nuimo_init_bt();
-    }
+  // Ignore the object if it is not the Nuimo or was found by an adapter not to be used
+  adapter = object_adapter(object);
+  if (adapter < 0) {
+    return;
   }
-}
 
+  // Just found the Nuimo I was looking for. So connect to it
+  path = g_dbus_object_get_object_path(object);
+  connect_device(path, adapter, (GDBusProxy*) g_dbus_object_manager_get_interface(manager, path, BT_DEVICE_NAME));
 
-/**
- * During debugging this may print some helpful information. Might not be used
- * in production code.
-*/
-void nuimo_print_status() {
-  printf("\nCurrent Nuimo Status\n");
-  printf("====================\n");
-  printf("  Got BT_ADAPTER proxy %s\n"   , my_nuimo->characteristic[BT_ADAPTER].proxy ? "yes" : " no");
-  printf("  Nuimo is%s connected\n"      , my_nuimo->characteristic[NUIMO].connected ? "" : " not");
-  printf("  Got Nuimo proxy %s\n"        , my_nuimo->characteristic[NUIMO].proxy ? "yes" : " no");
-  printf("  status->device_path   = %s\n", my_nuimo->characteristic[NUIMO].path);
-  if (my_nuimo->characteristic[NUIMO].path) {
-    printf("  status->battery_path  = %s\n", my_nuimo->characteristic[NUIMO_BATTERY].path);
-    printf("  status->led_path      = %s\n", my_nuimo->characteristic[NUIMO_LED].path);
-    printf("  status->button_path   = %s\n", my_nuimo->characteristic[NUIMO_BUTTON].path);
-    printf("  status->fly_path      = %s\n", my_nuimo->characteristic[NUIMO_FLY].path);
-    printf("  status->swipe_path    = %s\n", my_nuimo->characteristic[NUIMO_SWIPE].path);
-    printf("  status->rotation_path = %s\n", my_nuimo->characteristic[NUIMO_ROTATION].path);
-  }
-  printf("\n");
+  // Connect to object-removed signal to see if the Nuimo disappears
+  my_nuimo->object_removed_sig_hdl = g_signal_connect (my_nuimo->manager,
+						       "object-removed",
+						       G_CALLBACK (cb_object_removed),
+						       NULL);
 }
 
 
 /**
- * Sends the provided bit pattern to the connected Nuimo LED matrix. Format of the bitmap is the upper left
- * LED is in bitmap[0],bit 0; while the lower right LED is in bitmap[10], bit 0
+ * Checks if an object is the Nuimo and was found by an adapter to be used
  *
- * @param bitmap     Must be an array of 11 Bytes representing the 9x9 bitmap
- * @param brightness Is the brightness of the LED
- * @param timeout    The time the bitmap is displayed (0...25.5 seconds)
- * @param mode       Selects the transition mode of (0 = fade in, else fast transition between patterns)
- * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
-*/
-int  nuimo_set_led(const unsigned char* bitmap, const unsigned char brightness, const unsigned char timeout, const unsigned char mode) {
-  unsigned char  pattern[13];
-  GVariant      *varled;
-  GVariant      *vtest[2];
-  GError        *DBerror;
-
-  DEBUG_PRINT(("nuimo_set_led\n"));
-
-  memcpy(pattern, bitmap, 10);
-  pattern[10] = (bitmap[10] & 0x01) | (mode == 0 ? 0x00 : 0x10); 
-  pattern[11] = brightness;
-  pattern[12] = timeout;
+ * @param object An object of the object manager
+ * @return The index of the adapter or -1 if the object is not the Nuimo or the adapter may not be used
+ */
+static int object_adapter (GDBusObject *object) {
+  GDBusInterface *interface;
+  int             adapter = -1;
 
- 
-  vtest[0] = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, pattern, 13, 1);
-  vtest[1] = g_variant_new ("a{sv}", NULL);
-  varled = g_variant_new_tuple(vtest, 2);
+  interface = g_dbus_object_get_interface(object, BT_DEVICE_NAME);
+  if (!interface) {
+    return(-1);
+  }
 
-  DBerror = NULL;
-  g_dbus_proxy_call_sync(my_nuimo->characteristic[NUIMO_LED].proxy,
-			 "WriteValue",
-			 varled,
-			 G_DBUS_CALL_FLAGS_NONE,
-			 -1,
-			 NULL,
-			 &DBerror);
-  
-  if(DBerror) {
-    fprintf(stderr, "*EE* Error WriteValue: %s\n", DBerror->message);
-    g_variant_unref(varled);
-    g_variant_unref(vtest[0]);
-    g_variant_unref(vtest[1]);
-    g_error_free(DBerror);
-    return(EXIT_FAILURE);
+  if (is_my_nuimo(G_DBUS_PROXY(interface))) {
+    adapter = device_adapter(G_DBUS_PROXY(interface));
+    if (adapter >= 0 && !adapter_allowed(adapter)) {
+      adapter = -1;
+    }
   }
+  g_object_unref(interface);
 
-  return(EXIT_SUCCESS);
-}  
+  return(adapter);
+}
 
 
 /**
- * Displays the selected icon on the LED matrix. Dependin on the FW of the Nuimo you can
- * select one icon out of 255(?) 
+ * Called when the discovery reports the Nuimo. With several adapters to choose from, the
+ * connect is deferred for NUIMO_SETTLE_TIME so the other adapters can report the Nuimo
+ * as well; ::cb_settle then takes the least loaded one.
  *
- * @param icon       Icon to be displayed (e.g. 0 = epty, 1 = scan-animation, 2 = Yin&Yang, ...)
- * @param brightness Is the brightness of the LED
- * @param timeout    The time the bitmap is displayed (0...25.5 seconds)
+ * @return TRUE if the connect is deferred (or already is); FALSE to connect right away
+ */
+static gboolean start_settle () {
+  unsigned int i;
+  unsigned int allowed = 0;
+
+  if (my_nuimo->settling) {
+    return(TRUE);
+  }
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (adapter_allowed(i)) {
+      allowed++;
+    }
+  }
+  if (allowed < 2) {
+    return(FALSE);
+  }
+
+  DEBUG_PRINT(("start_settle\n"));
+
+  my_nuimo->settling   = TRUE;
+  my_nuimo->settle_src = g_timeout_add(NUIMO_SETTLE_TIME, cb_settle, NULL);
+  NUIMO_TRACE1(connect__state, "settling");
+
+  return(TRUE);
+}
+
+
+/**
+ * The discovery had time to settle: connects the Nuimo through the least loaded allowed adapter
+ * which reported it. In NUIMO_BUS_DIRECT mode the objects are read again asynchronously.
+ *
+ * @param user_data Not used
+ * @return FALSE to remove the timer
+ */
+static gboolean cb_settle (gpointer user_data) {
+  GList       *objects;
+  GDBusObject *object;
+
+  DEBUG_PRINT(("cb_settle\n"));
+
+  my_nuimo->settle_src = 0;
+
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    g_dbus_connection_call(my_nuimo->connection,
+			   my_nuimo->bus_owner,
+			   "/",
+			   "org.freedesktop.DBus.ObjectManager",
+			   "GetManagedObjects",
+			   NULL,
+			   G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+			   G_DBUS_CALL_FLAGS_NONE,
+			   -1,
+			   my_nuimo->cancellable,
+			   cb_settle_objects,
+			   NULL);
+    return(FALSE);
+  }
+
+  my_nuimo->settling = FALSE;
+  objects = g_dbus_object_manager_get_objects(my_nuimo->manager);
+  object  = select_nuimo(objects);
+  if (object) {
+    connect_nuimo(my_nuimo->manager, object);
+  }
+  g_list_free_full(objects, g_object_unref);
+
+  return(FALSE);
+}
+
+
+/**
+ * Completes the GetManagedObjects of ::cb_settle (NUIMO_BUS_DIRECT mode)
+ *
+ * @param source    The system bus
+ * @param res       The result of GetManagedObjects
+ * @param user_data Not used
+ */
+static void cb_settle_objects (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant    *result;
+  GVariant    *objects;
+  GError      *DBerror = NULL;
+  const gchar *path;
+  int          adapter = -1;
+
+  DEBUG_PRINT(("cb_settle_objects\n"));
+
+  result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &DBerror);
+  if (!result) {
+    if (!g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      fprintf(stderr, "*EE* Error GetManagedObjects: %s\n", DBerror->message);
+      my_nuimo->settling = FALSE;
+    }
+    g_error_free(DBerror);
+    return;
+  }
+
+  my_nuimo->settling = FALSE;
+  objects = g_variant_get_child_value(result, 0);
+  g_variant_unref(result);
+
+  path = select_nuimo_direct(objects, &adapter);
+  if (path && !my_nuimo->connecting && !my_nuimo->characteristic[NUIMO].connected) {
+    connect_device(path, adapter, new_proxy(path, BT_DEVICE_NAME));
+  }
+  g_variant_unref(objects);
+}
+
+
+/**
+ * Connects to the Nuimo. The Connect and StopDiscovery calls are issued asynchronously
+ * and in parallel; ::cb_connect_done continues the setup.
+ *
+ * @param path    D-Bus path of the Nuimo
+ * @param adapter Index of the adapter which found the Nuimo
+ * @param proxy   Proxy of the org.bluez.Device1 interface; the reference is taken over
+ */
+static void connect_device (const gchar *path, int adapter, GDBusProxy *proxy) {
+  DEBUG_PRINT(("connect_device\n"));
+
+  my_nuimo->characteristic[NUIMO].path  = strdup(path);
+  my_nuimo->characteristic[NUIMO].proxy = proxy;
+  my_nuimo->adapter_used = adapter;
+  my_nuimo->characteristic[BT_ADAPTER].proxy = g_object_ref(my_nuimo->adapter[adapter].proxy);
+
+  my_nuimo->connecting    = TRUE;
+  my_nuimo->connect_start = g_get_monotonic_time();
+  NUIMO_TRACE1(connect__state, "connecting");
+
+  // Connect to signals from Nuimo first; including if it gets disconnected. In NUIMO_BUS_DIRECT
+  // mode the match rule must be in place before BlueZ reports the connection
+  connect_value_signal(NUIMO);
+
+  g_dbus_proxy_call(my_nuimo->characteristic[NUIMO].proxy,
+		    "Connect",
+		    NULL,
+		    G_DBUS_CALL_FLAGS_NONE,
+		    -1,
+		    my_nuimo->cancellable,
+		    cb_connect_done,
+		    NULL);
+
+  // No need to wait for the connection; stop the discovery in parallel
+  stop_discovery();
+}
+
+
+/**
+ * Checks if the interface belongs to the Nuimo I'm looking for. It must be named Nuimo and
+ * match the key/value pair if given.
+ *
+ * @param proxy The interface to check
+ * @return TRUE if it is the Nuimo
+ */
+static gboolean is_my_nuimo (GDBusProxy *proxy) {
+  return(match_nuimo(g_dbus_proxy_get_cached_property(proxy, "Name"),
+		     my_nuimo->keyword ? g_dbus_proxy_get_cached_property(proxy, my_nuimo->keyword) : NULL));
+}
+
+
+/**
+ * Same as ::is_my_nuimo but checks the properties of a org.bluez.Device1 interface as
+ * received by GetManagedObjects or InterfacesAdded
+ *
+ * @param properties The a{sv} dictionary of the properties
+ * @return TRUE if it is the Nuimo
+ */
+static gboolean is_my_nuimo_props (GVariant *properties) {
+  return(match_nuimo(g_variant_lookup_value(properties, "Name", G_VARIANT_TYPE_STRING),
+		     my_nuimo->keyword ? g_variant_lookup_value(properties, my_nuimo->keyword, G_VARIANT_TYPE_STRING) : NULL));
+}
+
+
+/**
+ * Checks the name and the value of the keyword (see ::nuimo_init_search)
+ *
+ * @param name  The Name property or NULL; the reference is taken over
+ * @param value The property selected by the keyword or NULL; the reference is taken over
+ * @return TRUE if it is the Nuimo
+ */
+static gboolean match_nuimo (GVariant *name, GVariant *value) {
+  gboolean found;
+
+  found = name && !strcmp(NUIMO_NAME, g_variant_get_string(name, NULL));
+
+  // If keyword is set check if the value matches
+  if (found && my_nuimo->keyword) {
+    found = value && !strcmp(my_nuimo->value, g_variant_get_string(value, NULL));
+  }
+
+  if (name) {
+    g_variant_unref(name);
+  }
+  if (value) {
+    g_variant_unref(value);
+  }
+
+  return(found);
+}
+
+
+/**
+ * Completes the asynchronous Connect call. On success all characteristics already known
+ * to the object manager get subscribed; the remaining ones follow with the object-added signal.
+ *
+ * @param source    The Nuimo proxy
+ * @param res       The result of the call
+ * @param user_data Not used
+ */
+static void cb_connect_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant    *result;
+  GError      *DBerror = NULL;
+  GList       *objects;
+  GList       *ob_list;
+  unsigned int i;
+
+  DEBUG_PRINT(("cb_connect_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    if (!g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      fprintf(stderr, "*EE* Error connecting: %s\n", DBerror->message);
+      NUIMO_TRACE1(connect__state, "failed");
+      // Retry with backoff; an immediate retry would hammer bluetoothd
+      schedule_reconnect();
+    }
+    g_error_free(DBerror);
+    return;
+  }
+  g_variant_unref(result);
+
+  my_nuimo->connecting   = FALSE;
+  my_nuimo->stats.connect_time = g_get_monotonic_time() - my_nuimo->connect_start;
+  my_nuimo->characteristic[NUIMO].connected = TRUE;
+  state_reset(TRUE);
+  NUIMO_TRACE1(connect__state, "connected");
+
+  // All StartNotify calls are issued here without waiting for each other
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    // The paths got collected while connecting (see ::get_characteristics_direct); no lookup needed
+    for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+      if (my_nuimo->characteristic[i].path && !my_nuimo->characteristic[i].proxy) {
+	my_nuimo->characteristic[i].proxy = new_proxy(my_nuimo->characteristic[i].path, BT_CHARACTERISTIC_NAME);
+	if (my_nuimo->characteristic[i].proxy && (my_nuimo->subscription & NUIMO_MASK(i))) {
+	  subscribe_characteristic(i);
+	}
+      }
+    }
+  } else {
+    objects = g_dbus_object_manager_get_objects(my_nuimo->manager);
+    for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
+      get_characteristics(my_nuimo->manager, ob_list->data);
+    }
+    g_list_free_full(objects, g_object_unref);
+  }
+
+  check_ready();
+}
+
+
+/**
+ * Completes an asynchronous call where only errors are of interest
+ *
+ * @param source    The proxy used for the call
+ * @param res       The result of the call
+ * @param user_data Name of the method (used for the error message)
+ */
+static void cb_call_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *result;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_call_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    if (!g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      fprintf(stderr, "*EE* Error %s: %s\n", (const char*) user_data, DBerror->message);
+    }
+    g_error_free(DBerror);
+    return;
+  }
+  g_variant_unref(result);
+}
+
+
+/**
+ * Calls the user ready function once the Nuimo is connected, the LED characteristic is known
+ * and all subscribed characteristics have notifications enabled. After re-arming the
+ * notifications of the same connection (see ::resubscribe) only the health gets back to OK.
+ */
+static void check_ready () {
+  unsigned int i;
+
+  DEBUG_PRINT(("check_ready\n"));
+
+  if (my_nuimo->ready || !my_nuimo->characteristic[NUIMO].connected || !my_nuimo->characteristic[NUIMO_LED].proxy) {
+    return;
+  }
+
+  for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+    if ((my_nuimo->subscription & NUIMO_MASK(i)) && !my_nuimo->characteristic[i].notifying) {
+      return;
+    }
+  }
+
+  my_nuimo->ready      = TRUE;
+  my_nuimo->stats.ready_time = g_get_monotonic_time() - my_nuimo->connect_start;
+  my_nuimo->last_notify        = g_get_monotonic_time();
+  my_nuimo->reconnecting       = FALSE;
+  my_nuimo->reconnect_attempts = 0;
+  set_health(NUIMO_HEALTH_OK);
+  NUIMO_TRACE1(connect__state, "ready");
+
+  if (my_nuimo->announced) {
+    return;
+  }
+  my_nuimo->announced = TRUE;
+  queue_connection_event(NUIMO_CONNECTION_READY);
+
+  // Show the persistent frame again after a reconnect
+  if (my_nuimo->persistent && my_nuimo->persistent_frame[12]) {
+    cb_refresh_frame(NULL);
+  }
+
+  // Show widgets bound before the Nuimo was connected
+  if (my_nuimo->widget_dirty) {
+    write_widget_frame();
+  }
+
+  if (my_nuimo->ready_function) {
+    my_nuimo->ready_function(my_nuimo->ready_user_data);
+  }
+}
+
+
+/**
+ * Gather all characteristics of the connected Nuimo and setup change notification for all of them
+ *
+ * @param manager
+ * @param object
+ */
+static void get_characteristics(GDBusObjectManager *manager, GDBusObject *object) {
+  GVariant    *variant;
+  GList       *if_list, *interfaces;
+  const gchar *path;
+
+  DEBUG_PRINT(("get_characteristics\n"));
+
+  path = g_dbus_object_get_object_path(object);
+
+  // Only objects below the connected Nuimo are of interest
+  if (!g_str_has_prefix(path, my_nuimo->characteristic[NUIMO].path)) {
+    return;
+  }
+
+  interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (object));
+
+  for (if_list = interfaces; if_list != NULL; if_list = if_list->next) {
+    variant = g_dbus_proxy_get_cached_property (if_list->data, "UUID");
+
+    if (variant) {
+      add_characteristic(path, g_variant_get_string(variant, NULL), NULL);
+      g_variant_unref(variant);
+    }
+  }
+
+  g_list_free_full(interfaces, g_object_unref);
+}
+
+
+/**
+ * Takes over a characteristic of the Nuimo if the UUID is one of the known ones and subscribes
+ * it if selected.
+ *
+ * @param path  D-Bus path of the characteristic
+ * @param uuid  UUID of the characteristic
+ * @param proxy Proxy of the characteristic; NULL to get it from the object manager
+ */
+static void add_characteristic (const gchar *path, const gchar *uuid, GDBusProxy *proxy) {
+  unsigned int i;
+
+  for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+    if (!my_nuimo->characteristic[i].path && !strcmp(NUIMO_UUID[i], uuid)) {
+
+      my_nuimo->characteristic[i].path = strdup(path);
+
+      if (!proxy) {
+	proxy = (GDBusProxy*) g_dbus_object_manager_get_interface(my_nuimo->manager,
+								  my_nuimo->characteristic[i].path,
+								  BT_CHARACTERISTIC_NAME);
+      }
+      my_nuimo->characteristic[i].proxy = proxy;
+      DEBUG_PRINT(("UUID = %s\n", NUIMO_UUID[i]));
+
+      // Subscribe only the selected characteristics. The LED characteristic has no notify function
+      if (my_nuimo->subscription & NUIMO_MASK(i)) {
+	subscribe_characteristic(i);
+      }
+
+      return;
+    }
+  }
+
+  // Not one of the Nuimo characteristics
+  if (proxy) {
+    g_object_unref(proxy);
+  }
+}
+
+
+/**
+ * Starts the notification of a characteristic and connects the change-value signal.
+ * The StartNotify call is asynchronous, so all characteristics get armed in parallel.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ */
+static void subscribe_characteristic (unsigned int characteristic) {
+  DEBUG_PRINT(("subscribe_characteristic\n"));
+
+  connect_value_signal(characteristic);
+
+  g_dbus_proxy_call(my_nuimo->characteristic[characteristic].proxy,
+		    "StartNotify",
+		    NULL,
+		    G_DBUS_CALL_FLAGS_NONE,
+		    -1,
+		    my_nuimo->cancellable,
+		    cb_start_notify_done,
+		    GINT_TO_POINTER(characteristic));
+}
+
+
+/**
+ * Completes the asynchronous StartNotify call
+ *
+ * @param source    The characteristic proxy
+ * @param res       The result of the call
+ * @param user_data The characteristic based on ::nuimo_chars_e
+ */
+static void cb_start_notify_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant    *result;
+  GError      *DBerror = NULL;
+  unsigned int characteristic = GPOINTER_TO_INT(user_data);
+
+  DEBUG_PRINT(("cb_start_notify_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    if (!g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      fprintf(stderr, "*EE* Error StartNotify (UUID: %s): %s\n", NUIMO_UUID[characteristic], DBerror->message);
+      disconnect_value_signal(characteristic);
+      // The Nuimo would never get ready; start over with backoff, also without watchdog
+      g_error_free(DBerror);
+      schedule_reconnect();
+      return;
+    }
+    g_error_free(DBerror);
+    return;
+  }
+  g_variant_unref(result);
+
+  my_nuimo->characteristic[characteristic].notifying = TRUE;
+  check_ready();
+}
+
+
+/**
+ * Stops the notification of a characteristic and disconnects the change-value signal
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ */
+static void unsubscribe_characteristic (unsigned int characteristic) {
+  DEBUG_PRINT(("unsubscribe_characteristic\n"));
+
+  disconnect_value_signal(characteristic);
+  my_nuimo->characteristic[characteristic].notifying = FALSE;
+
+  g_dbus_proxy_call(my_nuimo->characteristic[characteristic].proxy,
+		    "StopNotify",
+		    NULL,
+		    G_DBUS_CALL_FLAGS_NONE,
+		    -1,
+		    my_nuimo->cancellable,
+		    cb_call_done,
+		    "StopNotify");
+}
+
+
+/**
+ * Receives a signal in case a object (Nuimo or characteristic) is newly found.
+ * While the Connect call is still running the object is ignored; ::cb_connect_done picks it up.
+ * The connect to a Nuimo found by the discovery may be deferred (see ::start_settle).
+ *
+ * @param manager
+ * @param object
+ * @param user_data
+ */
+static void cb_object_added (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data) {
+  DEBUG_PRINT(("cb_object_added\n"));
+
+  my_nuimo->stats.wakeups++;
+
+  if (my_nuimo->characteristic[NUIMO].connected) {
+    get_characteristics(manager, object);
+  } else if (!my_nuimo->connecting && object_adapter(object) >= 0 && !start_settle()) {
+    connect_nuimo(manager, object);
+  }
+}
+
+
+/**
+ * Receives a signal in case the Nuimo gets disconnected
+ * First all handles must released and thn the search needs to be re-initated
+ *
+ * @param manager
+ * @param object
+ * @param user_data
+ */
+static void cb_object_removed (GDBusObjectManager *manager, GDBusObject *object, gpointer user_data) {
+  DEBUG_PRINT(("cb_object_removed\n"));
+
+  GList    *if_list, *interfaces;
+  gboolean  found = FALSE;
+
+  my_nuimo->stats.wakeups++;
+
+  if (!my_nuimo->characteristic[BT_ADAPTER].proxy) {
+    return;
+  }
+  
+  // Check if the Nuimo triggered the object-removed event
+  interfaces = g_dbus_object_get_interfaces (G_DBUS_OBJECT (object));
+      
+  for (if_list = interfaces; if_list != NULL && !found; if_list = if_list->next) {
+    found = is_my_nuimo(if_list->data);
+  }
+
+  g_list_free_full(interfaces, g_object_unref);
+
+  if (found) {
+    // Do the hard way: remove everything and start from the beginning
+    restart();
+  }
+}
+
+
+/**
+ * Receives the property changes of all objects of the object manager (e.g. RSSI updates of
+ * other devices during discovery). Only counts the wakeup; the Nuimo has its own handlers.
+ *
+ * @param manager     Not used
+ * @param object      Not used
+ * @param interface   Not used
+ * @param changed     Not used
+ * @param invalidated Not used
+ * @param user_data   Not used
+ */
+static void cb_manager_properties_changed (GDBusObjectManager *manager, GDBusObject *object, GDBusProxy *interface, GVariant *changed, GStrv invalidated, gpointer user_data) {
+  my_nuimo->stats.wakeups++;
+}
+
+
+/**
+ * During debugging this may print some helpful information. Might not be used
+ * in production code.
+*/
+void nuimo_print_status() {
+  printf("\nCurrent Nuimo Status\n");
+  printf("====================\n");
+  printf("  Got BT_ADAPTER proxy %s\n"   , my_nuimo->characteristic[BT_ADAPTER].proxy ? "yes" : " no");
+  printf("  Known BT-Adapters     = %u\n", my_nuimo->adapters);
+  if (my_nuimo->characteristic[BT_ADAPTER].proxy) {
+    printf("  status->adapter_path  = %s\n", my_nuimo->adapter[my_nuimo->adapter_used].path);
+  }
+  printf("  Nuimo is%s connected\n"      , my_nuimo->characteristic[NUIMO].connected ? "" : " not");
+  printf("  Got Nuimo proxy %s\n"        , my_nuimo->characteristic[NUIMO].proxy ? "yes" : " no");
+  printf("  status->device_path   = %s\n", my_nuimo->characteristic[NUIMO].path);
+  if (my_nuimo->characteristic[NUIMO].path) {
+    printf("  status->battery_path  = %s\n", my_nuimo->characteristic[NUIMO_BATTERY].path);
+    printf("  status->led_path      = %s\n", my_nuimo->characteristic[NUIMO_LED].path);
+    printf("  status->button_path   = %s\n", my_nuimo->characteristic[NUIMO_BUTTON].path);
+    printf("  status->fly_path      = %s\n", my_nuimo->characteristic[NUIMO_FLY].path);
+    printf("  status->swipe_path    = %s\n", my_nuimo->characteristic[NUIMO_SWIPE].path);
+    printf("  status->rotation_path = %s\n", my_nuimo->characteristic[NUIMO_ROTATION].path);
+  }
+  printf("  state.battery         = %d\n", my_nuimo->state.battery);
+  printf("  state.rotation        = %lld\n", (long long) my_nuimo->state.rotation);
+  printf("  state.updates         = %llu\n", (unsigned long long) my_nuimo->state.updates);
+  printf("  stats.notifications   = %llu\n", (unsigned long long) my_nuimo->stats.notifications);
+  printf("  stats.batches         = %llu\n", (unsigned long long) my_nuimo->stats.batches);
+  printf("  stats.ready_time      = %lld us\n", (long long) my_nuimo->stats.ready_time);
+  printf("\n");
+}
+
+
+/**
+ * Sends the provided bit pattern to the connected Nuimo LED matrix. Format of the bitmap is the upper left
+ * LED is in bitmap[0],bit 0; while the lower right LED is in bitmap[10], bit 0
+ *
+ * @param bitmap     Must be an array of 11 Bytes representing the 9x9 bitmap
+ * @param brightness Is the brightness of the LED
+ * @param timeout    The time the bitmap is displayed (0...25.5 seconds)
+ * @param mode       Selects the transition mode of (0 = fade in, else fast transition between patterns)
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+*/
+int  nuimo_set_led(const unsigned char* bitmap, const unsigned char brightness, const unsigned char timeout, const unsigned char mode) {
+  unsigned char  pattern[13];
+
+  DEBUG_PRINT(("nuimo_set_led\n"));
+
+  led_pattern(pattern, bitmap, brightness, timeout, mode);
+
+  if (persist_frame(pattern)) {
+    return(EXIT_SUCCESS);
+  }
+
+  return(write_led(pattern));
+}  
+
+
+/**
+ * Builds the (floating) parameters of the WriteValue call of the LED characteristic
+ *
+ * @param pattern The complete pattern incl. brightness and timeout (13 bytes)
+ * @return The parameter tuple
+ */
+static GVariant *led_variant (const unsigned char *pattern) {
+  GVariant *vtest[2];
+
+  vtest[0] = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, pattern, 13, 1);
+  vtest[1] = g_variant_new ("a{sv}", NULL);
+
+  return(g_variant_new_tuple(vtest, 2));
+}
+
+
+/**
+ * Builds the 13 byte LED pattern of a bitmap. See ::nuimo_set_led for the parameters
+ */
+static void led_pattern (unsigned char *pattern, const unsigned char *bitmap, unsigned char brightness, unsigned char timeout, unsigned char mode) {
+  memcpy(pattern, bitmap, 10);
+  pattern[10] = (bitmap[10] & 0x01) | (mode == 0 ? 0x00 : 0x10); 
+  pattern[11] = brightness;
+  pattern[12] = timeout;
+}
+
+
+/**
+ * Builds the 13 byte LED pattern of a predefined icon. See ::nuimo_set_icon for the parameters
+ */
+static void icon_pattern (unsigned char *pattern, unsigned char icon, unsigned char brightness, unsigned char timeout, unsigned char mode) {
+  memset(pattern, 0, 13);
+  pattern[0]  = icon;
+  pattern[10] = 0x20 | (mode == 0 ? 0x00 : 0x10); 
+  pattern[11] = brightness;
+  pattern[12] = timeout;
+}
+
+
+/**
+ * Sends the 13 byte pattern to the LED characteristic. The call consumes the floating
+ * variants; only the result must be released.
+ *
+ * @param pattern The complete pattern incl. brightness and timeout
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ */
+static int write_led (const unsigned char *pattern) {
+  GVariant *result;
+  GError   *DBerror;
+  gint64    start;
+  guint64   id;
+
+  DEBUG_PRINT(("write_led\n"));
+
+  // Not connected (yet); the parameters are not even built
+  if (!my_nuimo->characteristic[NUIMO_LED].proxy) {
+    return(EXIT_FAILURE);
+  }
+
+  start = g_get_monotonic_time();
+  id    = ++my_nuimo->led_write_id;
+  NUIMO_TRACE2(led__write__start, id, "sync");
+  my_nuimo->adapter[my_nuimo->adapter_used].writes++;
+
+  DBerror = NULL;
+  result = g_dbus_proxy_call_sync(my_nuimo->characteristic[NUIMO_LED].proxy,
+				  "WriteValue",
+				  led_variant(pattern),
+				  G_DBUS_CALL_FLAGS_NONE,
+				  -1,
+				  NULL,
+				  &DBerror);
+  
+  if(!result) {
+    fprintf(stderr, "*EE* Error WriteValue: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    my_nuimo->frame_expiry = 0;
+    NUIMO_TRACE2(led__write__done, id, EXIT_FAILURE);
+    return(EXIT_FAILURE);
+  }
+
+  g_variant_unref(result);
+  NUIMO_TRACE2(led__write__done, id, EXIT_SUCCESS);
+  record_write_latency(g_get_monotonic_time() - start);
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Sets one LED of a 9x9 bitmap. The upper left LED is in bitmap[0], bit 0; the lower right LED
+ * is in bitmap[10], bit 0
+ *
+ * @param bitmap Array of 11 bytes
+ * @param row    Row 0...8
+ * @param col    Column 0...8
+ */
+static void set_pixel (unsigned char *bitmap, unsigned int row, unsigned int col) {
+  unsigned int pos = row * 9 + col;
+
+  bitmap[pos / 8] |= 1 << (pos % 8);
+}
+
+
+/**
+ * Renders the widget of a characteristic into a 9x9 bitmap
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param bitmap         Array of 11 bytes receiving the bitmap
+ */
+static void render_widget (unsigned int characteristic, unsigned char *bitmap) {
+  // 3x5 font for the digits 0...9; each entry holds five rows of three bits
+  static const unsigned char font[10][5] = {
+    {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+    {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7}
+  };
+  widget_s    *widget = &my_nuimo->widget[characteristic];
+  unsigned int level, i, row, col;
+  int          number;
+
+  memset(bitmap, 0, 11);
+
+  switch (widget->type) {
+  case NUIMO_WIDGET_BAR :
+    // In 64 bit; the range may be as wide as INT_MIN..INT_MAX
+    level = CLAMP(((gint64) widget->value - widget->min) * 9 / ((gint64) widget->max - widget->min), 0, 9);
+    for (col = 0; col < level; col++) {
+      for (row = 2; row < 7; row++) {
+	set_pixel(bitmap, row, col);
+      }
+    }
+    break;
+
+  case NUIMO_WIDGET_RING :
+    // 32 LEDs around the matrix, starting in the upper left corner
+    level = CLAMP(((gint64) widget->value - widget->min) * 32 / ((gint64) widget->max - widget->min), 0, 32);
+    for (i = 0; i < level; i++) {
+      if (i < 8) {
+	set_pixel(bitmap, 0, i);
+      } else if (i < 16) {
+	set_pixel(bitmap, i - 8, 8);
+      } else if (i < 24) {
+	set_pixel(bitmap, 8, 24 - i);
+      } else {
+	set_pixel(bitmap, 32 - i, 0);
+      }
+    }
+    break;
+
+  case NUIMO_WIDGET_NUMBER :
+    number = CLAMP(widget->value, 0, 99);
+    for (row = 0; row < 5; row++) {
+      for (col = 0; col < 3; col++) {
+	if (number < 10) {
+	  if (font[number][row] & (4 >> col)) {
+	    set_pixel(bitmap, row + 2, col + 3);
+	  }
+	} else {
+	  if (font[number / 10][row] & (4 >> col)) {
+	    set_pixel(bitmap, row + 2, col + 1);
+	  }
+	  if (font[number % 10][row] & (4 >> col)) {
+	    set_pixel(bitmap, row + 2, col + 5);
+	  }
+	}
+      }
+    }
+    break;
+
+  case NUIMO_WIDGET_SWITCH :
+    // Off is an empty frame, on a filled square
+    for (i = 0; i < 9; i++) {
+      set_pixel(bitmap, 0, i);
+      set_pixel(bitmap, 8, i);
+      set_pixel(bitmap, i, 0);
+      set_pixel(bitmap, i, 8);
+    }
+    if (widget->value > widget->min) {
+      for (row = 2; row < 7; row++) {
+	for (col = 2; col < 7; col++) {
+	  set_pixel(bitmap, row, col);
+	}
+      }
+    }
+    break;
+  }
+}
+
+
+/**
+ * Feeds a decoded event into the widget bound to the characteristic. The new value is rendered
+ * and written to the LED matrix without involving the application.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param number         The decoded value
+ * @param direction      The decoded direction
+ * @param timestamp      Arrival time of the event; used to measure the input-to-LED latency
+ */
+static void update_widget (unsigned int characteristic, int number, unsigned int direction, gint64 timestamp) {
+  widget_s *widget = &my_nuimo->widget[characteristic];
+  gint64    value  = widget->value;  // 64 bit, so the steps can not overflow close to INT_MIN/INT_MAX
+
+  DEBUG_PRINT(("update_widget\n"));
+
+  switch (characteristic) {
+  case NUIMO_BATTERY :
+    value = number;
+    break;
+
+  case NUIMO_BUTTON :
+    if (direction == NUIMO_BUTTON_PRESS) {
+      value = value == widget->max ? widget->min : widget->max;
+    }
+    break;
+
+  case NUIMO_SWIPE :
+    if (direction == NUIMO_SWIPE_RIGHT || direction == NUIMO_SWIPE_UP) {
+      value += widget->step;
+    } else if (direction == NUIMO_SWIPE_LEFT || direction == NUIMO_SWIPE_DOWN) {
+      value -= widget->step;
+    }
+    break;
+
+  case NUIMO_FLY :
+    if (direction == NUIMO_FLY_UPDOWN) {
+      value = widget->min + number * ((gint64) widget->max - widget->min) / 255;
+    } else {
+      value += direction == NUIMO_FLY_RIGHT ? widget->step : -widget->step;
+    }
+    break;
+
+  case NUIMO_ROTATION :
+    // step is the number of rotation units per value; keep the remainder for the next event
+    widget->remainder += number;
+    value             += widget->remainder / widget->step;
+    widget->remainder %= widget->step;
+    break;
+  }
+
+  value = CLAMP(value, widget->min, widget->max);
+  if (value == widget->value) {
+    return;
+  }
+  g_atomic_int_set(&widget->value, value);
+
+  show_widget(characteristic, timestamp);
+}
+
+
+/**
+ * Renders the widget and writes it to the LED matrix. While a write is pending only the latest
+ * frame is remembered and written after the pending write completed.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param timestamp      Arrival time of the event causing the change
+ */
+static void show_widget (unsigned int characteristic, gint64 timestamp) {
+  DEBUG_PRINT(("show_widget\n"));
+
+  render_widget(characteristic, my_nuimo->widget_frame);
+  my_nuimo->widget_frame[11] = NUIMO_WIDGET_BRIGHTNESS;
+  my_nuimo->widget_frame[12] = NUIMO_WIDGET_TIMEOUT;
+  my_nuimo->widget_frame[10] = (my_nuimo->widget_frame[10] & 0x01) | 0x10;
+  my_nuimo->widget_input     = timestamp;
+  my_nuimo->widget_dirty     = TRUE;
+
+  if (!my_nuimo->widget_busy) {
+    write_widget_frame();
+  }
+}
+
+
+/**
+ * Issues the asynchronous LED write of the current widget frame
+ */
+static void write_widget_frame () {
+  DEBUG_PRINT(("write_widget_frame\n"));
+
+  if (!my_nuimo->characteristic[NUIMO_LED].proxy) {
+    return;
+  }
+
+  my_nuimo->widget_busy    = TRUE;
+  my_nuimo->widget_dirty   = FALSE;
+  my_nuimo->widget_written = my_nuimo->widget_input;
+  my_nuimo->widget_start   = g_get_monotonic_time();
+  my_nuimo->widget_write_id = ++my_nuimo->led_write_id;
+  my_nuimo->stats.widget_writes++;
+  my_nuimo->adapter[my_nuimo->adapter_used].writes++;
+  NUIMO_TRACE2(led__write__start, my_nuimo->widget_write_id, "widget");
+
+  // The widget covers the persistent frame; bring it back once the widget lapsed
+  if (my_nuimo->persistent && my_nuimo->persistent_frame[12]) {
+    my_nuimo->frame_expiry = 0;
+    schedule_refresh(my_nuimo->widget_frame[12] * 100);
+  }
+
+  g_dbus_proxy_call(my_nuimo->characteristic[NUIMO_LED].proxy,
+		    "WriteValue",
+		    led_variant(my_nuimo->widget_frame),
+		    G_DBUS_CALL_FLAGS_NONE,
+		    -1,
+		    my_nuimo->cancellable,
+		    cb_widget_write_done,
+		    NULL);
+}
+
+
+/**
+ * Completes the widget LED write. Measures the latency and writes the next frame if the value
+ * changed in the meantime.
+ *
+ * @param source    The LED proxy
+ * @param res       The result of the call
+ * @param user_data Not used
+ */
+static void cb_widget_write_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *result;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_widget_write_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    if (g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free(DBerror);
+      return;
+    }
+    fprintf(stderr, "*EE* Error WriteValue: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    NUIMO_TRACE2(led__write__done, my_nuimo->widget_write_id, EXIT_FAILURE);
+  } else {
+    g_variant_unref(result);
+    NUIMO_TRACE2(led__write__done, my_nuimo->widget_write_id, EXIT_SUCCESS);
+    record_write_latency(g_get_monotonic_time() - my_nuimo->widget_start);
+    my_nuimo->stats.widget_latency     = g_get_monotonic_time() - my_nuimo->widget_written;
+    my_nuimo->stats.widget_latency_max = MAX(my_nuimo->stats.widget_latency_max, my_nuimo->stats.widget_latency);
+  }
+
+  my_nuimo->widget_busy = FALSE;
+  if (my_nuimo->widget_dirty) {
+    write_widget_frame();
+  }
+}
+
+
+/**
+ * Folds a frame of the user into the persistent display. The frame gets the maximum timeout and
+ * replaces the pending refresh. A frame identical to the one on the display is not written again.
+ *
+ * @param pattern The complete 13 byte pattern; the timeout byte gets changed in persistent mode
+ * @return TRUE if the write is redundant and must be skipped
+ */
+static gboolean persist_frame (unsigned char *pattern) {
+  gint64 now;
+  guint  spread = 0;
+
+  DEBUG_PRINT(("persist_frame\n"));
+
+  if (!my_nuimo->persistent || !my_nuimo->characteristic[NUIMO_LED].proxy) {
+    return(FALSE);
+  }
+
+  now         = g_get_monotonic_time();
+  pattern[12] = NUIMO_PERSISTENT_TIMEOUT;
+
+  if (my_nuimo->frame_expiry - now > NUIMO_REFRESH_LEAD * 1000 && !memcmp(pattern, my_nuimo->persistent_frame, 12)) {
+    my_nuimo->stats.skipped_writes++;
+    return(TRUE);
+  }
+
+  // Devices with different paths refresh at different times
+  if (my_nuimo->characteristic[NUIMO].path) {
+    spread = g_str_hash(my_nuimo->characteristic[NUIMO].path) % NUIMO_REFRESH_SPREAD;
+  }
+
+  memcpy(my_nuimo->persistent_frame, pattern, 13);
+  my_nuimo->frame_expiry = now + NUIMO_PERSISTENT_TIMEOUT * 100000;
+  schedule_refresh(NUIMO_PERSISTENT_TIMEOUT * 100 - NUIMO_REFRESH_LEAD - spread);
+
+  return(FALSE);
+}
+
+
+/**
+ * (Re)starts the refresh timer of the persistent frame. Only one refresh is pending at any time.
+ *
+ * @param delay Time in ms until the persistent frame gets written
+ */
+static void schedule_refresh (guint delay) {
+  DEBUG_PRINT(("schedule_refresh\n"));
+
+  if (my_nuimo->refresh_src) {
+    g_source_remove(my_nuimo->refresh_src);
+  }
+  my_nuimo->refresh_src = g_timeout_add(delay, cb_refresh_frame, NULL);
+}
+
+
+/**
+ * Writes the persistent frame again just before it lapses (or after a widget frame lapsed)
+ *
+ * @param user_data Not used
+ * @return FALSE; the timer is restarted by ::persist_frame
+ */
+static gboolean cb_refresh_frame (gpointer user_data) {
+  unsigned char pattern[13];
+
+  DEBUG_PRINT(("cb_refresh_frame\n"));
+
+  my_nuimo->refresh_src = 0;
+
+  if (!my_nuimo->persistent || !my_nuimo->ready || !my_nuimo->persistent_frame[12]) {
+    return(FALSE);
+  }
+
+  memcpy(pattern, my_nuimo->persistent_frame, 13);
+  my_nuimo->frame_expiry = 0;
+  persist_frame(pattern);
+  my_nuimo->stats.refreshes++;
+
+  call_async(NUIMO_LED, "WriteValue", led_variant(pattern), NULL, NULL);
+
+  return(FALSE);
+}
+
+
+/**
+ * Completes an asynchronous LED write which was skipped as redundant. The done function is
+ * called from the main loop like after a real write.
+ *
+ * @param done      Function to call on completion (may be NULL)
+ * @param user_data Pointer to user data handed over to the done function
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request could be issued or not
+ */
+static int skip_async (nuimo_done_function done, void *user_data) {
+  async_call_s *call;
+
+  DEBUG_PRINT(("skip_async\n"));
+
+  call = malloc(sizeof(async_call_s));
+  if (!call) {
+    return(EXIT_FAILURE);
+  }
+  call->done           = done;
+  call->user_data      = user_data;
+  call->characteristic = NUIMO_LED;
+  call->start          = g_get_monotonic_time();
+  call->id             = 0;
+
+  g_idle_add(cb_async_skipped, call);
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Calls the done function of a skipped write
+ *
+ * @param user_data The ::async_call_s of the call
+ * @return FALSE to remove the idle source
+ */
+static gboolean cb_async_skipped (gpointer user_data) {
+  async_call_s *call = user_data;
+
+  DEBUG_PRINT(("cb_async_skipped\n"));
+
+  if (call->done) {
+    call->done(EXIT_SUCCESS, NULL, 0, call->user_data);
+  }
+  free(call);
+
+  return(FALSE);
+}
+
+
+/**
+ * Changes the health state and informs the user
+ *
+ * @param health The new health state based on ::nuimo_health
+ */
+static void set_health (unsigned int health) {
+  unsigned int old_health = my_nuimo->health;
+
+  if (old_health == health) {
+    return;
+  }
+
+  DEBUG_PRINT(("set_health %u -> %u\n", old_health, health));
+
+  my_nuimo->health = health;
+  if (my_nuimo->health_function) {
+    my_nuimo->health_function(old_health, health, my_nuimo->health_user_data);
+  }
+}
+
+
+/**
+ * Adds a LED write latency to the moving average watched by the watchdog
+ *
+ * @param latency The latency of the write in microseconds
+ */
+static void record_write_latency (gint64 latency) {
+  my_nuimo->stats.write_latency = my_nuimo->stats.write_latency ? (7 * my_nuimo->stats.write_latency + latency) / 8 : latency;
+}
+
+
+/**
+ * Starts the watchdog timer if the watchdog is enabled or a reconnect is pending. This is the
+ * only timer of the watchdog; probe timeouts and the reconnect backoff are checked on each tick.
+ */
+static void start_watchdog () {
+  if ((my_nuimo->watchdog_silence || my_nuimo->reconnecting) && !my_nuimo->watchdog_src) {
+    my_nuimo->watchdog_src = g_timeout_add(NUIMO_WATCHDOG_TICK, cb_watchdog, NULL);
+  }
+}
+
+
+/**
+ * Stops the watchdog timer
+ */
+static void stop_watchdog () {
+  if (my_nuimo->watchdog_src) {
+    g_source_remove(my_nuimo->watchdog_src);
+    my_nuimo->watchdog_src = 0;
+  }
+}
+
+
+/**
+ * Tears down the connection and schedules a reconnect. The delay grows exponentially with
+ * each attempt and gets a random jitter of +-25% so several gateways do not reconnect in sync.
+ */
+static void schedule_reconnect () {
+  gint64 delay;
+
+  DEBUG_PRINT(("schedule_reconnect\n"));
+
+  delay = MIN((gint64) NUIMO_BACKOFF_MAX, (gint64) NUIMO_BACKOFF_BASE << MIN(my_nuimo->reconnect_attempts, 16));
+  delay = delay * g_random_double_range(0.75, 1.25);
+
+  my_nuimo->reconnect_attempts++;
+  my_nuimo->reconnect_at = g_get_monotonic_time() + delay * 1000;
+  my_nuimo->stats.reconnects++;
+
+  // Keep the watchdog running while disconnected
+  my_nuimo->reconnecting = TRUE;
+  set_health(NUIMO_HEALTH_RECONNECTING);
+  my_nuimo->restarting = TRUE;
+  teardown(0, FALSE);
+  my_nuimo->restarting = FALSE;
+
+  // The tick drives the reconnect even if the watchdog is disabled
+  start_watchdog();
+}
+
+
+/**
+ * Removes everything and starts from the beginning right away, e.g. after the Nuimo disconnected.
+ * The setup runs asynchronously; if it fails, or the Nuimo drops again before it got ready, the
+ * next attempt follows with backoff.
+ */
+static void restart () {
+  DEBUG_PRINT(("restart\n"));
+
+  if (my_nuimo->reconnecting) {
+    schedule_reconnect();
+    return;
+  }
+
+  my_nuimo->reconnecting = TRUE;
+  set_health(NUIMO_HEALTH_RECONNECTING);
+  my_nuimo->restarting = TRUE;
+  teardown(0, FALSE);
+  my_nuimo->restarting = FALSE;
+
+  if (nuimo_init_bt_async(NULL, NULL) != EXIT_SUCCESS) {
+    schedule_reconnect();
+  }
+}
+
+
+/**
+ * Checks the link with a cheap read (see ::cb_probe_done). The average write latency starts
+ * over, so a slow link is probed once and not on every tick.
+ */
+static void start_probe () {
+  DEBUG_PRINT(("start_probe\n"));
+
+  set_health(NUIMO_HEALTH_PROBING);
+  my_nuimo->probe_start         = g_get_monotonic_time();
+  my_nuimo->stats.probes++;
+  my_nuimo->stats.write_latency = 0;
+  if (nuimo_read_value_async(NUIMO_BATTERY, cb_probe_done, NULL) != EXIT_SUCCESS) {
+    schedule_reconnect();
+  }
+}
+
+
+/**
+ * Re-arms the notifications of all subscribed characteristics. The health gets back to OK
+ * once all StartNotify calls completed (see ::check_ready).
+ */
+static void resubscribe () {
+  unsigned int i;
+
+  DEBUG_PRINT(("resubscribe\n"));
+
+  set_health(NUIMO_HEALTH_RESUBSCRIBING);
+  my_nuimo->stats.resubscribes++;
+  my_nuimo->ready         = FALSE;
+  my_nuimo->connect_start = g_get_monotonic_time();
+
+  for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+    if (my_nuimo->characteristic[i].proxy && (my_nuimo->subscription & NUIMO_MASK(i))) {
+      if (my_nuimo->characteristic[i].char_sig_hdl) {
+	unsubscribe_characteristic(i);
+      }
+      subscribe_characteristic(i);
+    }
+  }
+}
+
+
+/**
+ * Completion of the probe read. A successful read shows the link is alive, so only the
+ * notifications get re-armed. Otherwise the Nuimo gets reconnected.
+ *
+ * @param result    EXIT_SUCCESS or EXIT_FAILURE
+ * @param data      Not used
+ * @param len       Not used
+ * @param user_data Not used
+ */
+static void cb_probe_done (int result, const unsigned char *data, unsigned int len, void *user_data) {
+  DEBUG_PRINT(("cb_probe_done\n"));
+
+  // Probe timed out or the connection got closed meanwhile
+  if (my_nuimo->health != NUIMO_HEALTH_PROBING) {
+    return;
+  }
+
+  if (result == EXIT_SUCCESS) {
+    my_nuimo->last_notify = g_get_monotonic_time();
+    resubscribe();
+  } else {
+    schedule_reconnect();
+  }
+}
+
+
+/**
+ * The watchdog tick. Checks the time since the last notification and the LED write latency
+ * and drives the probe and reconnect handling.
+ *
+ * @param user_data Not used
+ * @return FALSE to remove the timer once neither the watchdog nor a reconnect needs it
+ */
+static gboolean cb_watchdog (gpointer user_data) {
+  gint64   now = g_get_monotonic_time();
+  gboolean slow;
+
+  // Waiting for the next reconnect attempt
+  if (my_nuimo->reconnect_at) {
+    if (now >= my_nuimo->reconnect_at) {
+      my_nuimo->reconnect_at = 0;
+      // A failed setup schedules the next attempt (see ::init_done)
+      if (nuimo_init_bt_async(NULL, NULL) != EXIT_SUCCESS) {
+	schedule_reconnect();
+      }
+    }
+    return(TRUE);
+  }
+
+  // Only kept alive for the reconnect
+  if (!my_nuimo->watchdog_silence && !my_nuimo->reconnecting) {
+    my_nuimo->watchdog_src = 0;
+    return(FALSE);
+  }
+
+  // Connecting or re-arming the notifications got stuck
+  if (!my_nuimo->ready) {
+    if (my_nuimo->connect_start && now - my_nuimo->connect_start > NUIMO_READY_TIMEOUT * 1000) {
+      schedule_reconnect();
+    }
+    return(TRUE);
+  }
+
+  switch (my_nuimo->health) {
+  case NUIMO_HEALTH_OK :
+  case NUIMO_HEALTH_SLOW :
+    slow = my_nuimo->watchdog_write && my_nuimo->stats.write_latency > (gint64) my_nuimo->watchdog_write * 1000;
+    if (now - my_nuimo->last_notify > (gint64) my_nuimo->watchdog_silence * 1000) {
+      // Silence for too long: Check the link with a cheap read
+      start_probe();
+    } else if (slow && my_nuimo->health == NUIMO_HEALTH_SLOW) {
+      // Still slow one tick after crossing the threshold: escalate like after silence
+      start_probe();
+    } else if (my_nuimo->watchdog_write) {
+      set_health(slow ? NUIMO_HEALTH_SLOW : NUIMO_HEALTH_OK);
+    }
+    break;
+
+  case NUIMO_HEALTH_PROBING :
+    if (now - my_nuimo->probe_start > NUIMO_PROBE_TIMEOUT * 1000) {
+      schedule_reconnect();
+    }
+    break;
+  }
+
+  return(TRUE);
+}
+
+
+/**
+ * Calls the handlers registered for the characteristic of the event. The list is looked up
+ * directly by the characteristic; handlers of other characteristics are never touched.
+ * A handler may add or remove handlers: the running loop keeps the list it started with.
+ *
+ * @param event The event to hand over
+ */
+static void dispatch_handlers (const nuimo_event *event) {
+  handler_list_s *list = my_nuimo->handlers[event->characteristic];
+  unsigned int    i;
+
+  if (!list) {
+    return;
+  }
+
+  my_nuimo->dispatch_depth++;
+  for (i = 0; i < list->count; i++) {
+    if (list->handler[i].direction == NUIMO_DIRECTION_ANY || list->handler[i].direction == event->direction) {
+      list->handler[i].function(event, list->handler[i].user_data);
+    }
+  }
+  my_nuimo->dispatch_depth--;
+
+  if (!my_nuimo->dispatch_depth) {
+    free_retired_handlers();
+  }
+}
+
+
+/**
+ * Replaces the handler list of a characteristic. The old list is retired and freed as soon as
+ * no dispatch can use it anymore.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param list           The new list; NULL if no handler is left
+ */
+static void publish_handlers (unsigned int characteristic, handler_list_s *list) {
+  DEBUG_PRINT(("publish_handlers\n"));
+
+  if (my_nuimo->handlers[characteristic]) {
+    my_nuimo->handlers_retired = g_slist_prepend(my_nuimo->handlers_retired, my_nuimo->handlers[characteristic]);
+  }
+  my_nuimo->handlers[characteristic] = list;
+
+  if (!my_nuimo->dispatch_depth) {
+    free_retired_handlers();
+  }
+}
+
+
+/**
+ * Frees the retired handler lists. Must only be called while no dispatch is running.
+ */
+static void free_retired_handlers () {
+  g_slist_free_full(my_nuimo->handlers_retired, free);
+  my_nuimo->handlers_retired = NULL;
+}
+
+
+/**
+ * Calls the action bound to the event. The lookup is a single index into the binding table. The
+ * button state is the one stamped into the event on arrival, so it does not depend on the order
+ * of the batch or on button events arriving before the dispatch.
+ *
+ * @param event The event to dispatch
+ */
+static void dispatch_binding (const nuimo_event *event) {
+  binding_table_s *table = my_nuimo->bindings;
+  const binding_s *binding;
+
+  if (!table || !my_nuimo->action_function || event->direction >= NUIMO_BINDING_DIRECTIONS) {
+    return;
+  }
+
+  binding = &table->binding[event->characteristic][event->direction][event->held ? 1 : 0];
+  if (!binding->action) {
+    return;
+  }
+
+  my_nuimo->stats.actions++;
+  my_nuimo->dispatch_depth++;
+  my_nuimo->action_function(binding->action, binding->argument, event, my_nuimo->action_user_data);
+  my_nuimo->dispatch_depth--;
+
+  if (!my_nuimo->dispatch_depth) {
+    free_retired_handlers();
+  }
+}
+
+
+/**
+ * Looks up a name (case insensitive) in a list of names
+ *
+ * @param names The list; entries may be NULL
+ * @param len   Number of entries in names
+ * @param name  The name to look for
+ * @return The index of the name or -1 if unknown
+ */
+static int find_name (const char * const *names, unsigned int len, const char *name) {
+  unsigned int i;
+
+  for (i = 0; i < len; i++) {
+    if (names[i] && !g_ascii_strcasecmp(names[i], name)) {
+      return(i);
+    }
+  }
+
+  return(-1);
+}
+
+
+/**
+ * Compiles a binding config into a table. Each line holds one binding:
+ * \code
+ * <characteristic> <direction|*> <action> [argument] [held]
+ * \endcode
+ * Bindings with "held" apply only while the button is held and take precedence over the ones
+ * without. Empty lines and lines starting with '#' are ignored. A config binding a key
+ * (characteristic, direction and held) twice or holding an argument out of the int range is
+ * rejected.
+ *
+ * @param config The config text
+ * @return The new table (to be freed with free) or NULL in case of an error
+ */
+static binding_table_s *compile_bindings (const char *config) {
+  binding_table_s *table;
+  gboolean         bound[NUIMO_ENTRIES_LEN][NUIMO_BINDING_DIRECTIONS][2];
+  gchar          **lines;
+  gchar          **tokens;
+  char            *names;
+  char            *end;
+  const char      *action;
+  gint64           number;
+  int              characteristic, direction, argument;
+  unsigned int     i, j, count, held, first, last;
+  gboolean         has_argument;
+
+  DEBUG_PRINT(("compile_bindings\n"));
+
+  // The action names are copied behind the table; they can not be longer than the config
+  table = calloc(1, sizeof(binding_table_s) + strlen(config) + 1);
+  if (!table) {
+    return(NULL);
+  }
+  memset(bound, 0, sizeof(bound));
+  names = table->names;
+
+  lines = g_strsplit(config, "\n", -1);
+
+  for (i = 0; lines[i]; i++) {
+    g_strstrip(lines[i]);
+    if (!lines[i][0] || lines[i][0] == '#') {
+      continue;
+    }
+
+    // Collect the non-empty tokens in front of the array
+    tokens = g_strsplit_set(lines[i], " \t", -1);
+    for (j = 0, count = 0; tokens[j]; j++) {
+      if (tokens[j][0]) {
+	tokens[count++] = tokens[j];
+      } else {
+	g_free(tokens[j]);
+      }
+    }
+    tokens[count] = NULL;
+
+    characteristic = count < 3 ? -1 : find_name(NUIMO_CHAR_NAMES, NUIMO_ENTRIES_LEN, tokens[0]);
+    if (characteristic < 0) {
+      fprintf(stderr, "*EE* Binding line %u: Unknown characteristic or missing action\n", i + 1);
+      g_strfreev(tokens);
+      g_strfreev(lines);
+      free(table);
+      return(NULL);
+    }
+
+    if (!strcmp(tokens[1], "*")) {
+      direction = -1;
+    } else {
+      direction = find_name(NUIMO_DIRECTION_NAMES[characteristic], NUIMO_BINDING_DIRECTIONS, tokens[1]);
+      if (direction < 0) {
+	fprintf(stderr, "*EE* Binding line %u: Unknown direction %s\n", i + 1, tokens[1]);
+	g_strfreev(tokens);
+	g_strfreev(lines);
+	free(table);
+	return(NULL);
+      }
+    }
+
+    argument     = 0;
+    held         = FALSE;
+    has_argument = FALSE;
+    for (j = 3; j < count; j++) {
+      if (!g_ascii_strcasecmp(tokens[j], "held")) {
+	held = TRUE;
+	continue;
+      }
+      // Exactly one argument; it must be a complete number in the range of an int
+      errno  = 0;
+      number = g_ascii_strtoll(tokens[j], &end, 10);
+      if (has_argument || end == tokens[j] || *end || errno || number < G_MININT || number > G_MAXINT) {
+	fprintf(stderr, "*EE* Binding line %u: Invalid argument %s\n", i + 1, tokens[j]);
+	g_strfreev(tokens);
+	g_strfreev(lines);
+	free(table);
+	return(NULL);
+      }
+      argument     = number;
+      has_argument = TRUE;
+    }
+
+    first = direction < 0 ? 0 : direction;
+    last  = direction < 0 ? NUIMO_BINDING_DIRECTIONS - 1 : (unsigned int) direction;
+
+    // A key may only be bound once, also through "*"; otherwise the order of the lines would matter
+    for (j = first; j <= last; j++) {
+      if (NUIMO_DIRECTION_NAMES[characteristic][j] && bound[characteristic][j][held]) {
+	fprintf(stderr, "*EE* Binding line %u: Duplicate binding of %s %s%s\n", i + 1, NUIMO_CHAR_NAMES[characteristic],
+		NUIMO_DIRECTION_NAMES[characteristic][j], held ? " held" : "");
+	g_strfreev(tokens);
+	g_strfreev(lines);
+	free(table);
+	return(NULL);
+      }
+    }
+
+    action = strcpy(names, tokens[2]);
+    names += strlen(tokens[2]) + 1;
+
+    for (j = first; j <= last; j++) {
+      if (!NUIMO_DIRECTION_NAMES[characteristic][j]) {
+	continue;
+      }
+      bound[characteristic][j][held] = TRUE;
+      if (!held) {
+	table->binding[characteristic][j][0].action   = action;
+	table->binding[characteristic][j][0].argument = argument;
+      }
+      if (held || !bound[characteristic][j][1]) {
+	table->binding[characteristic][j][1].action   = action;
+	table->binding[characteristic][j][1].argument = argument;
+      }
+    }
+
+    g_strfreev(tokens);
+  }
+
+  g_strfreev(lines);
+
+  return(table);
+}
+
+
+/**
+ * Looks up an adapter by its D-Bus path
+ *
+ * @param path The D-Bus path of the adapter
+ * @return The index in my_nuimo->adapter or -1 if unknown
+ */
+static int find_adapter (const gchar *path) {
+  unsigned int i;
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (!strcmp(my_nuimo->adapter[i].path, path)) {
+      return(i);
+    }
+  }
+
+  return(-1);
+}
+
+
+/**
+ * Takes over an adapter found on the bus. Known adapters keep their entry (and counters).
+ *
+ * @param path  D-Bus path of the adapter
+ * @param proxy Proxy of the adapter; the reference is taken over
+ * @return The index in my_nuimo->adapter or -1 if there are too many adapters
+ */
+static int add_adapter (const gchar *path, GDBusProxy *proxy) {
+  int adapter;
+
+  adapter = find_adapter(path);
+
+  if (adapter < 0 && my_nuimo->adapters < NUIMO_ADAPTERS_MAX) {
+    adapter = my_nuimo->adapters++;
+    my_nuimo->adapter[adapter].path   = strdup(path);
+    my_nuimo->adapter[adapter].events = 0;
+    my_nuimo->adapter[adapter].writes = 0;
+  }
+
+  if (adapter < 0) {
+    fprintf(stderr, "*EE* Too many BT-Adapters; ignoring %s\n", path);
+    g_object_unref(proxy);
+    return(-1);
+  }
+  my_nuimo->adapter[adapter].proxy       = proxy;
+  my_nuimo->adapter[adapter].discovering = FALSE;
+
+  return(adapter);
+}
+
+
+/**
+ * Checks that at least one of the found adapters may be used
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int check_adapters () {
+  unsigned int i;
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (adapter_allowed(i)) {
+      return(EXIT_SUCCESS);
+    }
+  }
+
+  fprintf(stderr, "*EE* No BT-Adapter %s found\n", my_nuimo->adapter_pin ? my_nuimo->adapter_pin : "");
+  return(EXIT_FAILURE);
+}
+
+
+/**
+ * Returns the adapter a device was found by
+ *
+ * @param device Proxy of a org.bluez.Device1 object
+ * @return The index in my_nuimo->adapter or -1 if unknown
+ */
+static int device_adapter (GDBusProxy *device) {
+  GVariant *variant;
+  int       adapter;
+
+  variant = g_dbus_proxy_get_cached_property(device, "Adapter");
+  if (!variant) {
+    return(-1);
+  }
+  adapter = find_adapter(g_variant_get_string(variant, NULL));
+  g_variant_unref(variant);
+
+  return(adapter);
+}
+
+
+/**
+ * Checks if an adapter is present and may be used (see ::nuimo_init_adapter)
+ *
+ * @param adapter Index in my_nuimo->adapter
+ * @return TRUE if the adapter can be used
+ */
+static gboolean adapter_allowed (unsigned int adapter) {
+  const char *name;
+
+  if (!my_nuimo->adapter[adapter].proxy) {
+    return(FALSE);
+  }
+  if (!my_nuimo->adapter_pin) {
+    return(TRUE);
+  }
+
+  // The pin is either the complete path or just the name (e.g. "hci1")
+  name = strrchr(my_nuimo->adapter[adapter].path, '/');
+  return(!strcmp(my_nuimo->adapter_pin, my_nuimo->adapter[adapter].path) ||
+	 (name && !strcmp(my_nuimo->adapter_pin, name + 1)));
+}
+
+
+/**
+ * Counts the connected devices of each adapter. The Nuimo itself is not counted. The counts
+ * are kept in the adapter entries until the next lookup of the objects.
+ *
+ * @param objects All objects of the object manager
+ */
+static void adapter_loads (GList *objects) {
+  GList          *ob_list;
+  GDBusInterface *interface;
+  GVariant       *variant;
+  unsigned int    i;
+  int             adapter;
+
+  for (i = 0; i < NUIMO_ADAPTERS_MAX; i++) {
+    my_nuimo->adapter[i].devices = 0;
+  }
+
+  for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
+    interface = g_dbus_object_get_interface(ob_list->data, BT_DEVICE_NAME);
+    if (!interface) {
+      continue;
+    }
+
+    variant = g_dbus_proxy_get_cached_property(G_DBUS_PROXY(interface), "Connected");
+    if (variant && g_variant_get_boolean(variant) && !is_my_nuimo(G_DBUS_PROXY(interface))) {
+      adapter = device_adapter(G_DBUS_PROXY(interface));
+      if (adapter >= 0) {
+	my_nuimo->adapter[adapter].devices++;
+      }
+    }
+    if (variant) {
+      g_variant_unref(variant);
+    }
+    g_object_unref(interface);
+  }
+}
+
+
+/**
+ * Selects the known Nuimo to connect to. BlueZ keeps one device object per adapter which has
+ * seen the Nuimo; the one of the least loaded allowed adapter is taken.
+ *
+ * @param objects All objects of the object manager
+ * @return The object of the Nuimo (owned by objects) or NULL if none is known
+ */
+static GDBusObject *select_nuimo (GList *objects) {
+  GList          *ob_list;
+  GDBusInterface *interface;
+  GDBusObject    *best = NULL;
+  unsigned int    best_load = 0;
+  int             adapter;
+
+  DEBUG_PRINT(("select_nuimo\n"));
+
+  adapter_loads(objects);
+
+  for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
+    interface = g_dbus_object_get_interface(ob_list->data, BT_DEVICE_NAME);
+    if (!interface) {
+      continue;
+    }
+
+    if (is_my_nuimo(G_DBUS_PROXY(interface))) {
+      adapter = device_adapter(G_DBUS_PROXY(interface));
+      if (adapter >= 0 && adapter_allowed(adapter) && (!best || my_nuimo->adapter[adapter].devices < best_load)) {
+	best      = ob_list->data;
+	best_load = my_nuimo->adapter[adapter].devices;
+      }
+    }
+    g_object_unref(interface);
+  }
+
+  return(best);
+}
+
+
+/**
+ * Stops the discovery on all adapters. The calls are issued asynchronously and in parallel.
+ */
+static void stop_discovery () {
+  unsigned int i;
+
+  DEBUG_PRINT(("stop_discovery\n"));
+
+  if (!my_nuimo->active_discovery) {
+    return;
+  }
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (my_nuimo->adapter[i].proxy && my_nuimo->adapter[i].discovering) {
+      g_dbus_proxy_call(my_nuimo->adapter[i].proxy,
+			"StopDiscovery",
+			NULL,
+			G_DBUS_CALL_FLAGS_NONE,
+			-1,
+			my_nuimo->cancellable,
+			cb_call_done,
+			"StopDiscovery");
+      my_nuimo->adapter[i].discovering = FALSE;
+    }
+  }
+
+  my_nuimo->active_discovery = FALSE;
+  NUIMO_TRACE1(connect__state, "discovery-stopped");
+}
+
+
+/**
+ * Connects the change-value signal of a characteristic (or the Nuimo itself). In
+ * NUIMO_BUS_DIRECT mode a match rule scoped to the path and the interface is added to the bus.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ */
+static void connect_value_signal (unsigned int characteristic) {
+  characteristic_s *chr = &my_nuimo->characteristic[characteristic];
+
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    chr->char_sig_hdl = g_dbus_connection_signal_subscribe(my_nuimo->connection,
+							   BT_STACK,
+							   "org.freedesktop.DBus.Properties",
+							   "PropertiesChanged",
+							   chr->path,
+							   characteristic == NUIMO ? BT_DEVICE_NAME : BT_CHARACTERISTIC_NAME,
+							   G_DBUS_SIGNAL_FLAGS_NONE,
+							   cb_properties_changed,
+							   GINT_TO_POINTER(characteristic),
+							   NULL);
+  } else {
+    chr->char_sig_hdl = g_signal_connect (chr->proxy,
+					  "g-properties-changed",
+					  G_CALLBACK (cb_change_val_notify),
+					  GINT_TO_POINTER(characteristic));
+  }
+}
+
+
+/**
+ * Disconnects the change-value signal of a characteristic (or the Nuimo itself)
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ */
+static void disconnect_value_signal (unsigned int characteristic) {
+  characteristic_s *chr = &my_nuimo->characteristic[characteristic];
+
+  if (!chr->char_sig_hdl) {
+    return;
+  }
+
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    g_dbus_connection_signal_unsubscribe(my_nuimo->connection, chr->char_sig_hdl);
+  } else {
+    g_signal_handler_disconnect(chr->proxy, chr->char_sig_hdl);
+  }
+  chr->char_sig_hdl = 0;
+}
+
+
+/**
+ * Receives the PropertiesChanged signal in NUIMO_BUS_DIRECT mode and hands it over to
+ * ::cb_change_val_notify
+ *
+ * @param connection Not used
+ * @param sender     Not used
+ * @param path       Not used
+ * @param interface  Not used
+ * @param signal     Not used
+ * @param parameters (sa{sv}as) the interface, the changed and the invalidated properties
+ * @param user_data  The characteristic based on ::nuimo_chars_e
+ */
+static void cb_properties_changed (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data) {
+  const gchar  *changed_interface;
+  GVariant     *changed;
+  const gchar **invalidated;
+
+  my_nuimo->stats.wakeups++;
+  g_variant_get(parameters, "(&s@a{sv}^a&s)", &changed_interface, &changed, &invalidated);
+  cb_change_val_notify(NULL, changed, (GStrv) invalidated, user_data);
+  g_variant_unref(changed);
+  g_free(invalidated);
+}
+
+
+/**
+ * Creates a proxy without property cache and without signal subscription. Only method calls
+ * are done through it. As the unique name of BlueZ is used, no D-Bus call is needed.
+ *
+ * @param path      D-Bus path of the object
+ * @param interface The interface of the object
+ * @return The proxy or NULL in case of an error
+ */
+static GDBusProxy *new_proxy (const gchar *path, const gchar *interface) {
+  GDBusProxy *proxy;
+  GError     *DBerror = NULL;
+
+  proxy = g_dbus_proxy_new_sync(my_nuimo->connection,
+				G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+				NULL,
+				my_nuimo->bus_owner,
+				path,
+				interface,
+				NULL,
+				&DBerror);
+  if (!proxy) {
+    fprintf(stderr, "*EE* Error creating proxy for %s: %s\n", path, DBerror->message);
+    g_error_free(DBerror);
+  }
+
+  return(proxy);
+}
+
+
+/**
+ * Fetches all objects of BlueZ with a single GetManagedObjects call
+ *
+ * @return The a{oa{sa{sv}}} dictionary or NULL in case of an error
+ */
+static GVariant *get_managed_objects () {
+  GVariant *result;
+  GVariant *objects;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("get_managed_objects\n"));
+
+  result = g_dbus_connection_call_sync(my_nuimo->connection,
+				       BT_STACK,
+				       "/",
+				       "org.freedesktop.DBus.ObjectManager",
+				       "GetManagedObjects",
+				       NULL,
+				       G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+				       G_DBUS_CALL_FLAGS_NONE,
+				       -1,
+				       NULL,
+				       &DBerror);
+  if (!result) {
+    fprintf(stderr, "*EE* Error GetManagedObjects: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    return(NULL);
+  }
+
+  objects = g_variant_get_child_value(result, 0);
+  g_variant_unref(result);
+
+  return(objects);
+}
+
+
+/**
+ * Same as ::adapter_loads but based on the result of GetManagedObjects
+ *
+ * @param objects The a{oa{sa{sv}}} dictionary
+ */
+static void adapter_loads_direct (GVariant *objects) {
+  GVariantIter iter;
+  GVariant    *interfaces;
+  GVariant    *device;
+  const gchar *path;
+  const gchar *adapter_path;
+  gboolean     connected;
+  unsigned int i;
+  int          adapter;
+
+  for (i = 0; i < NUIMO_ADAPTERS_MAX; i++) {
+    my_nuimo->adapter[i].devices = 0;
+  }
+
+  g_variant_iter_init(&iter, objects);
+  while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+    device = g_variant_lookup_value(interfaces, BT_DEVICE_NAME, G_VARIANT_TYPE_VARDICT);
+
+    if (device) {
+      if (g_variant_lookup(device, "Connected", "b", &connected) && connected &&
+	  g_variant_lookup(device, "Adapter", "&o", &adapter_path) && !is_my_nuimo_props(device)) {
+	adapter = find_adapter(adapter_path);
+	if (adapter >= 0) {
+	  my_nuimo->adapter[adapter].devices++;
+	}
+      }
+      g_variant_unref(device);
+    }
+    g_variant_unref(interfaces);
+  }
+}
+
+
+/**
+ * Same as ::select_nuimo but based on the result of GetManagedObjects
+ *
+ * @param objects The a{oa{sa{sv}}} dictionary
+ * @param adapter Receives the index of the adapter
+ * @return The path of the Nuimo (owned by objects) or NULL if none is known
+ */
+static const gchar *select_nuimo_direct (GVariant *objects, int *adapter) {
+  GVariantIter iter;
+  GVariant    *interfaces;
+  GVariant    *device;
+  const gchar *path;
+  const gchar *adapter_path;
+  const gchar *best = NULL;
+  int          index;
+
+  DEBUG_PRINT(("select_nuimo_direct\n"));
+
+  adapter_loads_direct(objects);
+
+  g_variant_iter_init(&iter, objects);
+  while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+    device = g_variant_lookup_value(interfaces, BT_DEVICE_NAME, G_VARIANT_TYPE_VARDICT);
+
+    if (device) {
+      if (is_my_nuimo_props(device) && g_variant_lookup(device, "Adapter", "&o", &adapter_path)) {
+	index = find_adapter(adapter_path);
+	if (index >= 0 && adapter_allowed(index) && (!best || my_nuimo->adapter[index].devices < my_nuimo->adapter[*adapter].devices)) {
+	  best     = path;
+	  *adapter = index;
+	}
+      }
+      g_variant_unref(device);
+    }
+    g_variant_unref(interfaces);
+  }
+
+  return(best);
+}
+
+
+/**
+ * Same as ::get_characteristics but based on the interfaces received by GetManagedObjects
+ * or InterfacesAdded. While the connection is still being established only the path is kept.
+ *
+ * @param path       D-Bus path of the object
+ * @param interfaces The a{sa{sv}} dictionary of the interfaces
+ */
+static void get_characteristics_direct (const gchar *path, GVariant *interfaces) {
+  GVariant    *characteristic;
+  const gchar *uuid;
+
+  // Only objects below the connected Nuimo are of interest
+  if (!g_str_has_prefix(path, my_nuimo->characteristic[NUIMO].path)) {
+    return;
+  }
+
+  characteristic = g_variant_lookup_value(interfaces, BT_CHARACTERISTIC_NAME, G_VARIANT_TYPE_VARDICT);
+  if (!characteristic) {
+    return;
+  }
+
+  if (g_variant_lookup(characteristic, "UUID", "&s", &uuid)) {
+    if (my_nuimo->characteristic[NUIMO].connected) {
+      add_characteristic(path, uuid, new_proxy(path, BT_CHARACTERISTIC_NAME));
+    } else {
+      remember_characteristic(path, uuid);
+    }
+  }
+  g_variant_unref(characteristic);
+}
+
+
+/**
+ * Remembers the path of a Nuimo characteristic seen while connecting (NUIMO_BUS_DIRECT mode).
+ * ::cb_connect_done creates the proxy once the connection is established.
+ *
+ * @param path D-Bus path of the characteristic
+ * @param uuid UUID of the characteristic
+ */
+static void remember_characteristic (const gchar *path, const gchar *uuid) {
+  unsigned int i;
+
+  for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+    if (!my_nuimo->characteristic[i].path && !strcmp(NUIMO_UUID[i], uuid)) {
+      my_nuimo->characteristic[i].path = strdup(path);
+      return;
+    }
+  }
+}
+
+
+/**
+ * Receives the InterfacesAdded signal in NUIMO_BUS_DIRECT mode. It is sent once per new
+ * object; property updates of other devices (e.g. RSSI during discovery) are not received.
+ *
+ * @param connection Not used
+ * @param sender     Not used
+ * @param path       Not used
+ * @param interface  Not used
+ * @param signal     Not used
+ * @param parameters (oa{sa{sv}}) the path and the interfaces of the new object
+ * @param user_data  Not used
+ */
+static void cb_interfaces_added (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data) {
+  const gchar *object_path;
+  const gchar *adapter_path;
+  GVariant    *interfaces;
+  GVariant    *device;
+  int          adapter;
+
+  DEBUG_PRINT(("cb_interfaces_added\n"));
+
+  my_nuimo->stats.wakeups++;
+  g_variant_get(parameters, "(&o@a{sa{sv}})", &object_path, &interfaces);
+
+  if (my_nuimo->characteristic[NUIMO].connected || my_nuimo->connecting) {
+    get_characteristics_direct(object_path, interfaces);
+  } else {
+    device = g_variant_lookup_value(interfaces, BT_DEVICE_NAME, G_VARIANT_TYPE_VARDICT);
+
+    if (device) {
+      if (is_my_nuimo_props(device) && g_variant_lookup(device, "Adapter", "&o", &adapter_path)) {
+	adapter = find_adapter(adapter_path);
+	if (adapter >= 0 && adapter_allowed(adapter) && !start_settle()) {
+	  connect_device(object_path, adapter, new_proxy(object_path, BT_DEVICE_NAME));
+	}
+      }
+      g_variant_unref(device);
+    }
+  }
+
+  g_variant_unref(interfaces);
+}
+
+
+/**
+ * Receives the InterfacesRemoved signal in NUIMO_BUS_DIRECT mode to see if the Nuimo disappears
+ *
+ * @param connection Not used
+ * @param sender     Not used
+ * @param path       Not used
+ * @param interface  Not used
+ * @param signal     Not used
+ * @param parameters (oas) the path and the removed interfaces
+ * @param user_data  Not used
+ */
+static void cb_interfaces_removed (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data) {
+  const gchar *object_path;
+
+  DEBUG_PRINT(("cb_interfaces_removed\n"));
+
+  my_nuimo->stats.wakeups++;
+  g_variant_get(parameters, "(&oas)", &object_path, NULL);
+
+  if (my_nuimo->characteristic[NUIMO].path && !strcmp(object_path, my_nuimo->characteristic[NUIMO].path)) {
+    // Do the hard way: remove everything and start from the beginning
+    restart();
+  }
+}
+
+
+/**
+ * The part of ::nuimo_init_bt for NUIMO_BUS_DIRECT mode. Instead of an object manager for the
+ * whole BlueZ tree, the objects are read once and only the signals of interest are subscribed.
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int init_bt_direct () {
+  GError   *DBerror = NULL;
+  GVariant *result;
+  GVariant *objects;
+  int       status;
+
+  DEBUG_PRINT(("init_bt_direct\n"));
+
+  my_nuimo->connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &DBerror);
+  if (!my_nuimo->connection) {
+    fprintf(stderr, "*EE* Error getting the system bus: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    return(EXIT_FAILURE);
+  }
+
+  subscribe_direct();
+
+  result = g_dbus_connection_call_sync(my_nuimo->connection,
+				       "org.freedesktop.DBus",
+				       "/org/freedesktop/DBus",
+				       "org.freedesktop.DBus",
+				       "GetNameOwner",
+				       g_variant_new("(s)", BT_STACK),
+				       G_VARIANT_TYPE("(s)"),
+				       G_DBUS_CALL_FLAGS_NONE,
+				       -1,
+				       NULL,
+				       &DBerror);
+  if (!result) {
+    fprintf(stderr, "*EE* Error GetNameOwner: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    return(EXIT_FAILURE);
+  }
+  g_variant_get(result, "(s)", &my_nuimo->bus_owner);
+  g_variant_unref(result);
+
+  objects = get_managed_objects();
+  if (!objects) {
+    return(EXIT_FAILURE);
+  }
+
+  status = setup_direct(objects);
+  g_variant_unref(objects);
+
+  return(status);
+}
+
+
+/**
+ * Subscribes the signals of BlueZ used in NUIMO_BUS_DIRECT mode. This is done before the objects
+ * are read so no new object gets lost.
+ */
+static void subscribe_direct () {
+  DEBUG_PRINT(("subscribe_direct\n"));
+
+  my_nuimo->object_added_sig_hdl = g_dbus_connection_signal_subscribe(my_nuimo->connection,
+								      BT_STACK,
+								      "org.freedesktop.DBus.ObjectManager",
+								      "InterfacesAdded",
+								      "/",
+								      NULL,
+								      G_DBUS_SIGNAL_FLAGS_NONE,
+								      cb_interfaces_added,
+								      NULL,
+								      NULL);
+  my_nuimo->object_removed_sig_hdl = g_dbus_connection_signal_subscribe(my_nuimo->connection,
+									BT_STACK,
+									"org.freedesktop.DBus.ObjectManager",
+									"InterfacesRemoved",
+									"/",
+									NULL,
+									G_DBUS_SIGNAL_FLAGS_NONE,
+									cb_interfaces_removed,
+									NULL,
+									NULL);
+}
+
+
+/**
+ * Takes over the BT-Adapters and the Nuimo (if already known) from the objects of BlueZ
+ * in NUIMO_BUS_DIRECT mode
+ *
+ * @param objects The a{oa{sa{sv}}} dictionary received by GetManagedObjects
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int setup_direct (GVariant *objects) {
+  GVariant    *interfaces;
+  GVariant    *properties;
+  GVariantIter iter;
+  const gchar *path;
+  const gchar *nuimo_path;
+  GDBusProxy  *proxy;
+  int          adapter = -1;
+
+  DEBUG_PRINT(("setup_direct\n"));
+
+  g_variant_iter_init(&iter, objects);
+  while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+    properties = g_variant_lookup_value(interfaces, BT_ADAPTER_NAME, G_VARIANT_TYPE_VARDICT);
+    if (properties) {
+      proxy = new_proxy(path, BT_ADAPTER_NAME);
+      if (proxy) {
+	add_adapter(path, proxy);
+      }
+      g_variant_unref(properties);
+    }
+    g_variant_unref(interfaces);
+  }
+
+  if (check_adapters() != EXIT_SUCCESS) {
+    return(EXIT_FAILURE);
+  }
+
+  nuimo_path = select_nuimo_direct(objects, &adapter);
+  if (nuimo_path) {
+    proxy = new_proxy(nuimo_path, BT_DEVICE_NAME);
+    if (proxy) {
+      connect_device(nuimo_path, adapter, proxy);
+
+      // Characteristics BlueZ has cached already; the others follow with InterfacesAdded
+      g_variant_iter_init(&iter, objects);
+      while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+	get_characteristics_direct(path, interfaces);
+	g_variant_unref(interfaces);
+      }
+    }
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Displays the selected icon on the LED matrix. Dependin on the FW of the Nuimo you can
+ * select one icon out of 255(?) 
+ *
+ * @param icon       Icon to be displayed (e.g. 0 = epty, 1 = scan-animation, 2 = Yin&Yang, ...)
+ * @param brightness Is the brightness of the LED
+ * @param timeout    The time the bitmap is displayed (0...25.5 seconds)
+ * @param mode       Selects the transition mode of (0 = fade in, else fast transition between patterns)
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+*/
+int nuimo_set_icon(const unsigned char icon, const unsigned char brightness, const unsigned char timeout, const unsigned char mode)
+{
+  unsigned char  pattern[13];
+
+  DEBUG_PRINT(("nuimo_set_icon\n"));
+
+  icon_pattern(pattern, icon, brightness, timeout, mode);
+
+  if (persist_frame(pattern)) {
+    return(EXIT_SUCCESS);
+  }
+
+  return(write_led(pattern));
+}
+
+
+/**
+ * Issue a read value. After the read is done the callback function is issued and returning the requestedd
+ * value characteristic indicates wich walue is requested;
+ *
+ * @param characteristic Defines the characteristic to read from ::nuimo_chars_e
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+*/
+int  nuimo_read_value(const unsigned char characteristic) {
+  GVariant *sendvar;
+  GVariant *result;
+  GError   *DBerror;
+
+  DEBUG_PRINT(("nuimo_read_value\n"));
+
+  if (characteristic >= NUIMO_ENTRIES_LEN || !my_nuimo->characteristic[characteristic].proxy) {
+    return(EXIT_FAILURE);
+  }
+ 
+  // Adding no flags, but build the structure
+  sendvar = g_variant_new ("(a{sv})", NULL);
+
+  DBerror = NULL;
+  result = g_dbus_proxy_call_sync(my_nuimo->characteristic[characteristic].proxy,
+				  "ReadValue",
+				  sendvar,
+				  G_DBUS_CALL_FLAGS_NONE,
+				  -1,
+				  NULL,
+				  &DBerror);
+  
+  if(!result) {
+    fprintf(stderr, "*EE* Error RedadValue: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    return(EXIT_FAILURE);
+  }
+
+  g_variant_unref(result);
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Issues an asynchronous call on a characteristic. The done function is called in any case once
+ * the call completed, failed or got cancelled by ::nuimo_disconnect.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param method         The name of the method
+ * @param parameters     The floating parameters of the method
+ * @param done           Function to call on completion (may be NULL)
+ * @param user_data      Pointer to user data handed over to the done function
+ * @return Returns EXIT_FAILURE if the characteristic is unknown; the done function is not called in this case
+ */
+static int call_async (unsigned int characteristic, const char *method, GVariant *parameters, nuimo_done_function done, void *user_data) {
+  async_call_s *call;
+
+  DEBUG_PRINT(("call_async\n"));
+
+  if (characteristic >= NUIMO_ENTRIES_LEN || !my_nuimo->characteristic[characteristic].proxy) {
+    g_variant_unref(g_variant_ref_sink(parameters));
+    return(EXIT_FAILURE);
+  }
+
+  call = malloc(sizeof(async_call_s));
+  if (!call) {
+    g_variant_unref(g_variant_ref_sink(parameters));
+    return(EXIT_FAILURE);
+  }
+  call->done           = done;
+  call->user_data      = user_data;
+  call->characteristic = characteristic;
+  call->start          = g_get_monotonic_time();
+  call->id             = 0;
+
+  if (characteristic == NUIMO_LED) {
+    call->id = ++my_nuimo->led_write_id;
+    NUIMO_TRACE2(led__write__start, call->id, "async");
+    my_nuimo->adapter[my_nuimo->adapter_used].writes++;
+  }
+
+  g_dbus_proxy_call(my_nuimo->characteristic[characteristic].proxy,
+		    method,
+		    parameters,
+		    G_DBUS_CALL_FLAGS_NONE,
+		    -1,
+		    my_nuimo->cancellable,
+		    cb_async_done,
+		    call);
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Completes an asynchronous call issued by ::call_async and calls the user done function.
+ * In case of ReadValue the received bytes are handed over.
+ *
+ * @param source    The characteristic proxy
+ * @param res       The result of the call
+ * @param user_data The ::async_call_s of the call
+ */
+static void cb_async_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  async_call_s        *call  = user_data;
+  GVariant            *result;
+  GVariant            *value = NULL;
+  GError              *DBerror = NULL;
+  const unsigned char *data  = NULL;
+  gsize                len   = 0;
+  int                  status = EXIT_SUCCESS;
+
+  DEBUG_PRINT(("cb_async_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    if (!g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      fprintf(stderr, "*EE* Error in asynchronous call: %s\n", DBerror->message);
+    }
+    g_error_free(DBerror);
+    status = EXIT_FAILURE;
+    if (call->characteristic == NUIMO_LED) {
+      // The frame on the display is unknown; do not skip the next write
+      my_nuimo->frame_expiry = 0;
+    }
+  } else if (call->characteristic == NUIMO_LED) {
+    record_write_latency(g_get_monotonic_time() - call->start);
+  } else if (g_variant_is_of_type(result, G_VARIANT_TYPE("(ay)"))) {
+    value = g_variant_get_child_value(result, 0);
+    data  = g_variant_get_fixed_array(value, &len, 1);
+  }
+
+  if (call->id) {
+    NUIMO_TRACE2(led__write__done, call->id, status);
+  }
+
+  if (call->done) {
+    call->done(status, data, len, call->user_data);
+  }
+
+  if (value) {
+    g_variant_unref(value);
+  }
+  if (result) {
+    g_variant_unref(result);
+  }
+  free(call);
+}
+
+
+/**
+ * Asynchronous version of ::nuimo_set_led. The function returns immediately; the done function
+ * is called from the GLib main loop once the write completed.
+ *
+ * @param bitmap     Must be an array of 11 Bytes representing the 9x9 bitmap
+ * @param brightness Is the brightness of the LED
+ * @param timeout    The time the bitmap is displayed (0...25.5 seconds)
  * @param mode       Selects the transition mode of (0 = fade in, else fast transition between patterns)
+ * @param done       Function to call on completion (may be NULL)
+ * @param user_data  Pointer to user data handed over to the done function
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request could be issued or not
+ */
+int nuimo_set_led_async(const unsigned char* bitmap, const unsigned char brightness, const unsigned char timeout, const unsigned char mode,
+			nuimo_done_function done, void *user_data) {
+  unsigned char pattern[13];
+
+  DEBUG_PRINT(("nuimo_set_led_async\n"));
+
+  led_pattern(pattern, bitmap, brightness, timeout, mode);
+
+  if (persist_frame(pattern)) {
+    return(skip_async(done, user_data));
+  }
+
+  return(call_async(NUIMO_LED, "WriteValue", led_variant(pattern), done, user_data));
+}
+
+
+/**
+ * Asynchronous version of ::nuimo_set_icon. See ::nuimo_set_led_async
+ */
+int nuimo_set_icon_async(const unsigned char icon, const unsigned char brightness, const unsigned char timeout, const unsigned char mode,
+			 nuimo_done_function done, void *user_data) {
+  unsigned char pattern[13];
+
+  DEBUG_PRINT(("nuimo_set_icon_async\n"));
+
+  icon_pattern(pattern, icon, brightness, timeout, mode);
+
+  if (persist_frame(pattern)) {
+    return(skip_async(done, user_data));
+  }
+
+  return(call_async(NUIMO_LED, "WriteValue", led_variant(pattern), done, user_data));
+}
+
+
+/**
+ * Enables the persistent display. The last frame written by ::nuimo_set_led, ::nuimo_set_icon or
+ * their asynchronous versions stays on the display: it is written with the maximum timeout and
+ * refreshed once just before it lapses (the timeout parameter is ignored). Refreshes of different
+ * devices are spread over NUIMO_REFRESH_SPREAD ms. A frame identical to the one on the display is
+ * not written again, a new frame replaces the pending refresh. After a widget frame lapsed and
+ * after a reconnect the persistent frame is shown again.
+ *
+ * @param persistent TRUE to keep the last frame on the display; FALSE lets it lapse as usual
+ */
+void nuimo_set_persistent(gboolean persistent) {
+  DEBUG_PRINT(("nuimo_set_persistent\n"));
+
+  my_nuimo->persistent = persistent;
+
+  if (!persistent) {
+    if (my_nuimo->refresh_src) {
+      g_source_remove(my_nuimo->refresh_src);
+      my_nuimo->refresh_src = 0;
+    }
+    memset(my_nuimo->persistent_frame, 0, 13);
+    my_nuimo->frame_expiry = 0;
+  }
+}
+
+
+/**
+ * Asynchronous read of a characteristic. The value is handed over to the done function (and,
+ * like with ::nuimo_read_value, delivered as event if the characteristic is subscribed).
+ *
+ * @param characteristic Defines the characteristic to read from ::nuimo_chars_e
+ * @param done           Function to call on completion (may be NULL)
+ * @param user_data      Pointer to user data handed over to the done function
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request could be issued or not
+ */
+int nuimo_read_value_async(const unsigned char characteristic, nuimo_done_function done, void *user_data) {
+  DEBUG_PRINT(("nuimo_read_value_async\n"));
+
+  return(call_async(characteristic, "ReadValue", g_variant_new ("(a{sv})", NULL), done, user_data));
+}
+
+
+/**
+ * Copies a consistent snapshot of the current Nuimo state. The function is wait-free for the
+ * writer and can be called from any thread; it never causes D-Bus traffic. In the rare case the
+ * main loop updates the state while copying, the copy is simply repeated.
+ *
+ * @param state Pointer to the structure receiving the snapshot
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ */
+int nuimo_get_state(struct nuimo_state_s *state) {
+  guint seq;
+
+  DEBUG_PRINT(("nuimo_get_state\n"));
+
+  if (!my_nuimo || !state) {
+    return(EXIT_FAILURE);
+  }
+
+  do {
+    seq = __atomic_load_n(&my_nuimo->state_seq, __ATOMIC_ACQUIRE);
+    memcpy(state, &my_nuimo->state, sizeof(struct nuimo_state_s));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || seq != __atomic_load_n(&my_nuimo->state_seq, __ATOMIC_RELAXED));
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Selects the characteristics sending notifications. Can be called before ::nuimo_init_bt or at
+ * any time while connected; only the changed characteristics get subscribed or unsubscribed.
+ * Every notification wakes up the process, so subscribe only what you need. The StartNotify and
+ * StopNotify calls are asynchronous; errors are reported on stderr.
+ * Note: The result of ::nuimo_read_value is delivered only for subscribed characteristics.
+ *
+ * @param mask Combination of NUIMO_MASK(characteristic) values (see \ref NUIMO_MASKS)
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ */
+int nuimo_set_subscription(unsigned int mask) {
+  unsigned int i;
+
+  DEBUG_PRINT(("nuimo_set_subscription\n"));
+
+  my_nuimo->subscription = mask & NUIMO_MASK_ALL;
+
+  for (i = NUIMO_BATTERY; i < NUIMO_ENTRIES_LEN; i++) {
+    if (!my_nuimo->characteristic[i].proxy) {
+      continue;
+    }
+
+    if ((my_nuimo->subscription & NUIMO_MASK(i)) && !my_nuimo->characteristic[i].char_sig_hdl) {
+      subscribe_characteristic(i);
+    } else if (!(my_nuimo->subscription & NUIMO_MASK(i)) && my_nuimo->characteristic[i].char_sig_hdl) {
+      unsubscribe_characteristic(i);
+    }
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Copies the load counters. Sample the counters twice to get e.g. the wakeups per second.
+ * Must be called from the thread running the GLib main loop.
+ *
+ * @param stats Pointer to the structure receiving the counters
+ */
+void nuimo_get_stats(struct nuimo_stats_s *stats) {
+  DEBUG_PRINT(("nuimo_get_stats\n"));
+
+  memcpy(stats, &my_nuimo->stats, sizeof(struct nuimo_stats_s));
+}
+
+
+/**
+ * Binds a LED widget to a characteristic. The library keeps the value within min...max, changes it
+ * with every event of the characteristic and shows it on the LED matrix. Several writes are
+ * coalesced, so a fast rotation causes only one pending write. The value changes as follows:
+ * \n \n
+ * NUIMO_ROTATION Adds rotation / step \n
+ * NUIMO_SWIPE    Adds step for swipe right/up, subtracts step for swipe left/down \n
+ * NUIMO_FLY      Adds/subtracts step for fly right/left; the up/down value is mapped to min...max \n
+ * NUIMO_BUTTON   Toggles between min and max on press \n
+ * NUIMO_BATTERY  Takes the battery level
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param widget         The widget based on ::nuimo_widget; NUIMO_WIDGET_NONE removes the widget
+ * @param min            Lower limit of the value
+ * @param max            Upper limit of the value; must be greater than min
+ * @param value          Initial value
+ * @param step           See above; must be greater than 0
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ *
+ * min, max, value and step are ignored for NUIMO_WIDGET_NONE; the last value stays readable.
+ */
+int nuimo_bind_widget(unsigned int characteristic, unsigned int widget, int min, int max, int value, int step) {
+  DEBUG_PRINT(("nuimo_bind_widget\n"));
+
+  if (characteristic < NUIMO_BATTERY || characteristic >= NUIMO_ENTRIES_LEN || characteristic == NUIMO_LED ||
+      widget >= NUIMO_WIDGET_LEN) {
+    return(EXIT_FAILURE);
+  }
+
+  if (widget == NUIMO_WIDGET_NONE) {
+    my_nuimo->widget[characteristic].type      = NUIMO_WIDGET_NONE;
+    my_nuimo->widget[characteristic].remainder = 0;
+    return(EXIT_SUCCESS);
+  }
+
+  if (max <= min || step <= 0) {
+    return(EXIT_FAILURE);
+  }
+
+  my_nuimo->widget[characteristic].type      = widget;
+  my_nuimo->widget[characteristic].min       = min;
+  my_nuimo->widget[characteristic].max       = max;
+  my_nuimo->widget[characteristic].step      = step;
+  my_nuimo->widget[characteristic].remainder = 0;
+  g_atomic_int_set(&my_nuimo->widget[characteristic].value, CLAMP(value, min, max));
+
+  show_widget(characteristic, g_get_monotonic_time());
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Returns the current value of the widget bound to the characteristic. Can be called from any thread.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @return The value of the widget
+ */
+int nuimo_get_widget_value(unsigned int characteristic) {
+  DEBUG_PRINT(("nuimo_get_widget_value\n"));
+
+  if (characteristic >= NUIMO_ENTRIES_LEN) {
+    return(0);
+  }
+
+  return(g_atomic_int_get(&my_nuimo->widget[characteristic].value));
+}
+
+
+/**
+ * Disconnects and frees everything the status holds so ::nuimo_init_status can start over
+ * with the same instance
+ */
+static void free_status () {
+  unsigned int i;
+
+  DEBUG_PRINT(("free_status\n"));
+
+  nuimo_disconnect();
+
+  if (my_nuimo->dispatch_src) {
+    g_source_remove(my_nuimo->dispatch_src);
+  }
+  g_array_free(my_nuimo->events, TRUE);
+  g_array_free(my_nuimo->batch, TRUE);
+  g_array_free(my_nuimo->continuous, TRUE);
+
+  for (i = 0; i < NUIMO_ENTRIES_LEN; i++) {
+    free(my_nuimo->handlers[i]);
+  }
+  g_slist_free_full(my_nuimo->handlers_retired, free);
+  free(my_nuimo->bindings);
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    free(my_nuimo->adapter[i].path);
+  }
+  free(my_nuimo->adapter_pin);
+  free(my_nuimo->keyword);
+  free(my_nuimo->value);
+}
+
+
+/**
+ * Initializes the my_nuimo structure. Calling it again disconnects and starts over with the
+ * same instance.
+ *
  * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ */
+int nuimo_init_status() {
+  unsigned int i;
+
+  DEBUG_PRINT(("nuimo_init_status\n"));
+
+  // A second call starts over with the same instance
+  if (my_nuimo) {
+    free_status();
+  } else {
+    my_nuimo = malloc(sizeof(struct nuimo_status_s));
+  }
+
+  if (!my_nuimo) {
+    return(EXIT_FAILURE);
+  }
+
+  my_nuimo->keyword     = NULL;
+  my_nuimo->value       = NULL;
+  my_nuimo->manager     = NULL;
+  my_nuimo->cb_function = NULL;
+  my_nuimo->user_data   = NULL;
+
+  my_nuimo->batch_function  = NULL;
+  my_nuimo->batch_user_data = NULL;
+  my_nuimo->events          = g_array_sized_new(FALSE, FALSE, sizeof(nuimo_event), 32);
+  my_nuimo->batch           = g_array_sized_new(FALSE, FALSE, sizeof(nuimo_event), 32);
+  my_nuimo->dispatch_src    = 0;
+  my_nuimo->continuous      = g_array_sized_new(FALSE, FALSE, sizeof(nuimo_event), NUIMO_ENTRIES_LEN);
+  for (i = 0; i < NUIMO_ENTRIES_LEN; i++) {
+    my_nuimo->continuous_slot[i] = -1;
+  }
+  my_nuimo->event_seq       = 0;
+  my_nuimo->subscription    = NUIMO_MASK_ALL;
+  my_nuimo->cancellable     = NULL;
+  my_nuimo->connecting      = FALSE;
+  my_nuimo->ready           = FALSE;
+  my_nuimo->announced       = FALSE;
+  my_nuimo->connect_start   = 0;
+  my_nuimo->ready_function  = NULL;
+  my_nuimo->ready_user_data = NULL;
+  my_nuimo->widget_busy     = FALSE;
+  my_nuimo->widget_dirty    = FALSE;
+  my_nuimo->widget_write_id = 0;
+  my_nuimo->led_write_id    = 0;
+  my_nuimo->persistent      = FALSE;
+  memset(my_nuimo->persistent_frame, 0, 13);
+  my_nuimo->frame_expiry    = 0;
+  my_nuimo->refresh_src     = 0;
+  my_nuimo->teardown_pending = 0;
+  my_nuimo->teardown_failed  = 0;
+
+  for (i = 0; i < NUIMO_ENTRIES_LEN; i++) {
+    my_nuimo->handlers[i] = NULL;
+  }
+  my_nuimo->handlers_retired = NULL;
+  my_nuimo->handler_id       = 0;
+  my_nuimo->dispatch_depth   = 0;
+  my_nuimo->bindings         = NULL;
+  my_nuimo->action_function  = NULL;
+  my_nuimo->action_user_data = NULL;
+
+  for (i = 0; i < NUIMO_ADAPTERS_MAX; i++) {
+    my_nuimo->adapter[i].path        = NULL;
+    my_nuimo->adapter[i].proxy       = NULL;
+    my_nuimo->adapter[i].discovering = FALSE;
+    my_nuimo->adapter[i].events      = 0;
+    my_nuimo->adapter[i].writes      = 0;
+    my_nuimo->adapter[i].devices     = 0;
+  }
+  my_nuimo->adapters     = 0;
+  my_nuimo->adapter_used = 0;
+  my_nuimo->adapter_pin  = NULL;
+  my_nuimo->bus_mode     = NUIMO_BUS_MANAGER;
+  my_nuimo->connection   = NULL;
+  my_nuimo->bus_owner    = NULL;
+
+  my_nuimo->health             = NUIMO_HEALTH_DOWN;
+  my_nuimo->health_function    = NULL;
+  my_nuimo->health_user_data   = NULL;
+  my_nuimo->watchdog_silence   = 0;
+  my_nuimo->watchdog_write     = 0;
+  my_nuimo->watchdog_src       = 0;
+  my_nuimo->last_notify        = 0;
+  my_nuimo->probe_start        = 0;
+  my_nuimo->reconnecting       = FALSE;
+  my_nuimo->restarting         = FALSE;
+  my_nuimo->reconnect_at       = 0;
+  my_nuimo->reconnect_attempts = 0;
+  memset(&my_nuimo->stats, 0, sizeof(struct nuimo_stats_s));
+
+  my_nuimo->object_added_sig_hdl   = 0;
+  my_nuimo->object_removed_sig_hdl = 0;
+  my_nuimo->wakeup_sig_hdl         = 0;
+  
+  my_nuimo->active_discovery = FALSE;
+  my_nuimo->settling         = FALSE;
+  my_nuimo->settle_src       = 0;
+
+  i = 0;
+  while (i < NUIMO_ENTRIES_LEN) {
+    my_nuimo->characteristic[i].connected    = FALSE;
+    my_nuimo->characteristic[i].path         = NULL;
+    my_nuimo->characteristic[i].proxy        = NULL;
+    my_nuimo->characteristic[i].char_sig_hdl = 0;
+    my_nuimo->characteristic[i].notifying    = FALSE;
+    my_nuimo->widget[i].type                 = NUIMO_WIDGET_NONE;
+    my_nuimo->widget[i].value                = 0;
+    i++;
+  }
+
+  my_nuimo->state_seq = 0;
+  state_reset(FALSE);
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Sets Keyword and Value to search for. Useful if more than one Nuimo is in the area
+ * In case the Keyword or value is already set it will be deleted
+ *
+ * @param key The keyword (e.g. "Address")
+ * @param val The value you're looking for (e.g. "xx:xx:xx:xx:xx:xx")
 */
-int nuimo_set_icon(const unsigned char icon, const unsigned char brightness, const unsigned char timeout, const unsigned char mode)
-{
-  unsigned char  pattern[13] = { 0 };
-  GVariant      *varled;
-  GVariant      *vtest[2];
-  GError        *DBerror;
+int nuimo_init_search(const char* key, const char* val) {
+  DEBUG_PRINT(("nuimo_init_search\n"));
+  
+  if (key && val) {
+    if (my_nuimo->keyword) {
+      free(my_nuimo->keyword);
+    }
+    if (my_nuimo->value) {
+      free(my_nuimo->value);
+    }
+    
+    my_nuimo->keyword = malloc(strlen(key) + 1);
+    my_nuimo->value   = malloc(strlen(val) + 1);
+    if (!my_nuimo->keyword || !my_nuimo->value) {
+      return(EXIT_FAILURE);
+    }
+    
+    strcpy(my_nuimo->keyword, key);
+    strcpy(my_nuimo->value,   val);
+  }
+  
+  return(EXIT_SUCCESS);
+}
+
+/**
+ * Assigns the callback function for the user. The function must receive three values:
+ * void cb_function(uint characteristic, int value, uint direction) with the following parameters:
+ * \n \n 
+ * characteristic The identifier (see ::characteristic_s) \n 
+ * value          The value of movement. In case of SWIPE/TOUCH the value is 0 \n 
+ * direction      Informs you about direction of movement. In case of BUTTON and BATTERY events the value is 0
+ * \n \n
+ * The function is kept for compatibility. It gets called for each event of a batch, see ::nuimo_init_batch_function
+ */
+void nuimo_init_cb_function(void *cb_function, void *user_data) {
+  DEBUG_PRINT(("nuimo_init_cb_function\n"));
+  
+  my_nuimo->cb_function = cb_function;
+  my_nuimo->user_data = user_data;
+}
 
-  DEBUG_PRINT(("nuimo_set_icon\n"));
 
-  pattern[0]  = icon;
-  pattern[10] = 0x20 | (mode == 0 ? 0x00 : 0x10); 
-  pattern[11] = brightness;
-  pattern[12] = timeout;
+/**
+ * Registers a handler for one characteristic. Any number of handlers can be registered, e.g. by
+ * independent modules of one program. A handler is only called for events of its characteristic
+ * and, if given, the matching direction. Handlers may be added or removed at any time, even from
+ * within a handler; the change applies to the next event.
+ *
+ * @param characteristic The characteristic based on ::nuimo_chars_e
+ * @param direction      Only call for this direction (see \ref NUIMO_DIRECTIONS) or NUIMO_DIRECTION_ANY
+ * @param function       The function to call
+ * @param user_data      Pointer to user data handed over to the function
+ * @return The id of the handler for ::nuimo_remove_handler; 0 in case of an error
+ */
+unsigned int nuimo_add_handler(unsigned int characteristic, unsigned int direction, nuimo_handler_function function, void *user_data) {
+  handler_list_s *old;
+  handler_list_s *list;
+  unsigned int    count;
+
+  DEBUG_PRINT(("nuimo_add_handler\n"));
+
+  if (characteristic >= NUIMO_ENTRIES_LEN || !function) {
+    return(0);
+  }
+
+  old   = my_nuimo->handlers[characteristic];
+  count = old ? old->count : 0;
+
+  list = malloc(sizeof(handler_list_s) + (count + 1) * sizeof(handler_s));
+  if (!list) {
+    return(0);
+  }
+
+  if (count) {
+    memcpy(list->handler, old->handler, count * sizeof(handler_s));
+  }
+  list->count = count + 1;
+  list->handler[count].id        = ++my_nuimo->handler_id;
+  list->handler[count].direction = direction;
+  list->handler[count].function  = function;
+  list->handler[count].user_data = user_data;
+
+  publish_handlers(characteristic, list);
+
+  return(list->handler[count].id);
+}
+
+
+/**
+ * Removes a handler registered with ::nuimo_add_handler
+ *
+ * @param id The id returned by nuimo_add_handler
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the id is unknown
+ */
+int nuimo_remove_handler(unsigned int id) {
+  handler_list_s *old;
+  handler_list_s *list;
+  unsigned int    i, j, k;
+
+  DEBUG_PRINT(("nuimo_remove_handler\n"));
+
+  for (i = 0; i < NUIMO_ENTRIES_LEN; i++) {
+    old = my_nuimo->handlers[i];
+
+    for (j = 0; old && j < old->count; j++) {
+      if (old->handler[j].id != id) {
+	continue;
+      }
+
+      list = NULL;
+      if (old->count > 1) {
+	list = malloc(sizeof(handler_list_s) + (old->count - 1) * sizeof(handler_s));
+	if (!list) {
+	  return(EXIT_FAILURE);
+	}
+	list->count = 0;
+	for (k = 0; k < old->count; k++) {
+	  if (k != j) {
+	    list->handler[list->count++] = old->handler[k];
+	  }
+	}
+      }
+
+      publish_handlers(i, list);
+      return(EXIT_SUCCESS);
+    }
+  }
+
+  return(EXIT_FAILURE);
+}
+
+
+/**
+ * Loads a binding config which maps events to actions. The config is compiled into a table
+ * indexed by characteristic, direction and button state, so the dispatch of an event is a single
+ * lookup. Each line holds one binding:
+ * \code
+ * # <characteristic> <direction|*> <action> [argument] [held]
+ * BUTTON   PRESS  scene      1
+ * SWIPE    LEFT   scene     -1
+ * ROTATION *      volume
+ * ROTATION *      brightness 0 held
+ * \endcode
+ * The characteristics are CONNECTION, BATTERY, BUTTON, FLY, SWIPE and ROTATION, the directions
+ * are the names of \ref NUIMO_DIRECTIONS without the prefix (e.g. LONG_TOUCH_LEFT) or * for all.
+ * Bindings with "held" apply only while the button is held. The bound actions are handed over to
+ * the function installed with ::nuimo_init_action_function.
+ * \n \n
+ * The new table replaces the current one at once and can be loaded at any time, even from within
+ * an action. In case of an error the current table is kept.
+ *
+ * @param config The config text; NULL removes all bindings
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the config was valid or not
+ */
+int nuimo_load_bindings(const char *config) {
+  binding_table_s *table = NULL;
+
+  DEBUG_PRINT(("nuimo_load_bindings\n"));
+
+  if (config) {
+    table = compile_bindings(config);
+    if (!table) {
+      return(EXIT_FAILURE);
+    }
+  }
+
+  if (my_nuimo->bindings) {
+    my_nuimo->handlers_retired = g_slist_prepend(my_nuimo->handlers_retired, my_nuimo->bindings);
+  }
+  my_nuimo->bindings = table;
+
+  if (!my_nuimo->dispatch_depth) {
+    free_retired_handlers();
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Loads a binding config from a file. See ::nuimo_load_bindings
+ *
+ * @param filename The name of the config file
+ * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the config was valid or not
+ */
+int nuimo_load_bindings_file(const char *filename) {
+  gchar  *config;
+  GError *error = NULL;
+  int     result;
+
+  DEBUG_PRINT(("nuimo_load_bindings_file\n"));
+
+  if (!g_file_get_contents(filename, &config, NULL, &error)) {
+    fprintf(stderr, "*EE* Error reading %s: %s\n", filename, error->message);
+    g_error_free(error);
+    return(EXIT_FAILURE);
+  }
+
+  result = nuimo_load_bindings(config);
+  g_free(config);
+
+  return(result);
+}
+
+
+/**
+ * Assigns the action function. It is called for each event with an action bound by
+ * ::nuimo_load_bindings.
+ *
+ * @param action_function The function to call; NULL removes the function
+ * @param user_data       Pointer to user data handed over to the action function
+ */
+void nuimo_init_action_function(nuimo_action_function action_function, void *user_data) {
+  DEBUG_PRINT(("nuimo_init_action_function\n"));
+
+  my_nuimo->action_function  = action_function;
+  my_nuimo->action_user_data = user_data;
+}
+
+
+/**
+ * Selects the BT-Adapter to use for the Nuimo. By default all adapters are searched and an
+ * already known Nuimo is connected through the adapter with the fewest connected devices.
+ * Must be called before ::nuimo_init_bt.
+ *
+ * @param adapter Name (e.g. "hci1") or D-Bus path of the adapter; NULL for automatic placement
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int nuimo_init_adapter(const char *adapter) {
+  DEBUG_PRINT(("nuimo_init_adapter\n"));
+
+  free(my_nuimo->adapter_pin);
+  my_nuimo->adapter_pin = NULL;
+
+  if (adapter) {
+    my_nuimo->adapter_pin = strdup(adapter);
+    if (!my_nuimo->adapter_pin) {
+      return(EXIT_FAILURE);
+    }
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Selects how the SDK follows the objects of BlueZ. Must be called before ::nuimo_init_bt.
+ * \n \n
+ * NUIMO_BUS_MANAGER (default) keeps an object manager with a property cache of the complete
+ * BlueZ tree. Every property change of every device nearby (e.g. RSSI during discovery) wakes
+ * up the process. \n
+ * NUIMO_BUS_DIRECT reads the objects once and subscribes only the signals of the Nuimo and its
+ * characteristics plus the added/removed objects. The proxies have no property cache.
+ *
+ * @param mode Based on ::nuimo_bus_mode
+ * @return EXIT_SUCCESS or EXIT_FAILURE for an unknown mode
+ */
+int nuimo_init_bus_mode(unsigned int mode) {
+  DEBUG_PRINT(("nuimo_init_bus_mode\n"));
+
+  if (mode >= NUIMO_BUS_LEN) {
+    return(EXIT_FAILURE);
+  }
+
+  my_nuimo->bus_mode = mode;
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Reports the known BT-Adapters together with the events received and the LED writes sent
+ * through each of them. The counters are kept over reconnects. No D-Bus call is made: the
+ * connected devices are counted from the object manager cache, or in NUIMO_BUS_DIRECT mode
+ * taken from the last lookup of the objects (setup or discovery).
+ *
+ * @param stats Array to be filled
+ * @param max   Number of entries in stats
+ * @return Number of entries filled
+ */
+unsigned int nuimo_get_adapter_stats(struct nuimo_adapter_stats_s *stats, unsigned int max) {
+  GList       *objects;
+  unsigned int i;
+
+  DEBUG_PRINT(("nuimo_get_adapter_stats\n"));
+
+  if (my_nuimo->manager) {
+    objects = g_dbus_object_manager_get_objects(my_nuimo->manager);
+    adapter_loads(objects);
+    g_list_free_full(objects, g_object_unref);
+  }
+
+  for (i = 0; i < my_nuimo->adapters && i < max; i++) {
+    g_strlcpy(stats[i].path, my_nuimo->adapter[i].path, sizeof(stats[i].path));
+    stats[i].present = my_nuimo->adapter[i].proxy != NULL;
+    stats[i].in_use  = my_nuimo->characteristic[NUIMO].connected && my_nuimo->adapter_used == i;
+    stats[i].devices = my_nuimo->adapter[i].devices + (stats[i].in_use ? 1 : 0);
+    stats[i].events  = my_nuimo->adapter[i].events;
+    stats[i].writes  = my_nuimo->adapter[i].writes;
+  }
+
+  return(i);
+}
+
+
+/**
+ * Assigns the batch callback function. Instead of one call per event the function receives
+ * all events which arrived in one main loop iteration as an array of ::nuimo_event.
+ * Each event carries the arrival time, a sequence number and the raw payload.
+ * The batch function can be used together with the function set by ::nuimo_init_cb_function.
+ *
+ * @param batch_function The function receiving the events; NULL removes the function
+ * @param user_data      Pointer to user data handed over to the batch function
+ */
+void nuimo_init_batch_function(nuimo_batch_function batch_function, void *user_data) {
+  DEBUG_PRINT(("nuimo_init_batch_function\n"));
+
+  my_nuimo->batch_function  = batch_function;
+  my_nuimo->batch_user_data = user_data;
+}
+
+
+/**
+ * Assigns the ready function. It is called each time the Nuimo is connected and all
+ * subscribed characteristics have their notifications armed. From now on events will arrive.
+ * The time needed to get ready can be read with ::nuimo_get_stats.
+ *
+ * @param ready_function The function to call; NULL removes the function
+ * @param user_data      Pointer to user data handed over to the ready function
+ */
+void nuimo_init_ready_function(nuimo_ready_function ready_function, void *user_data) {
+  DEBUG_PRINT(("nuimo_init_ready_function\n"));
+
+  my_nuimo->ready_function  = ready_function;
+  my_nuimo->ready_user_data = user_data;
+}
+
+
+/**
+ * Issues one call of the teardown on the private main context of ::teardown. The reply is
+ * dropped; only the step gets marked as failed in case of an error. Without cancellable the
+ * call is sent without waiting for a reply at all.
+ *
+ * @param proxy       The proxy of the object
+ * @param method      The name of the method (without parameters)
+ * @param step        The step based on \ref NUIMO_TEARDOWN
+ * @param deadline    Time in ms the call may take
+ * @param cancellable Cancels the call once the deadline passed; NULL to not wait for the call
+ */
+static void teardown_call (GDBusProxy *proxy, const char *method, unsigned int step, unsigned int deadline, GCancellable *cancellable) {
+  DEBUG_PRINT(("teardown_call\n"));
+
+  if (!cancellable) {
+    g_dbus_proxy_call(proxy, method, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+    return;
+  }
+
+  my_nuimo->teardown_pending++;
+
+  g_dbus_proxy_call(proxy,
+		    method,
+		    NULL,
+		    G_DBUS_CALL_FLAGS_NONE,
+		    MAX(deadline, 1),
+		    cancellable,
+		    cb_teardown_done,
+		    GUINT_TO_POINTER(step));
+}
+
+
+/**
+ * Completes a teardown call. Errors are not reported; the Nuimo might be gone already.
+ *
+ * @param source    The proxy of the object
+ * @param res       The result of the call
+ * @param user_data The step based on \ref NUIMO_TEARDOWN
+ */
+static void cb_teardown_done (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *result;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_teardown_done\n"));
+
+  result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &DBerror);
+
+  if (DBerror) {
+    my_nuimo->teardown_failed |= GPOINTER_TO_UINT(user_data);
+    g_error_free(DBerror);
+  } else {
+    g_variant_unref(result);
+  }
+
+  my_nuimo->teardown_pending--;
+}
+
+
+/**
+ * Marks the deadline of the teardown as passed
+ *
+ * @param user_data Pointer to the gboolean to set
+ * @return FALSE to remove the timer
+ */
+static gboolean cb_teardown_deadline (gpointer user_data) {
+  DEBUG_PRINT(("cb_teardown_deadline\n"));
+
+  *((gboolean*) user_data) = TRUE;
+
+  return(FALSE);
+}
+
+
+/**
+ * Enables the link-health watchdog. It watches the time since the last notification and the
+ * average LED write latency. If the Nuimo stays silent for too long the link gets probed with a
+ * read of the battery level; on success the notifications are re-armed, otherwise the Nuimo is
+ * reconnected using a jittered exponential backoff. Slow LED writes are reported as
+ * NUIMO_HEALTH_SLOW. Use ::nuimo_init_health_function to follow the transitions.
+ *
+ * @param silence Max. time in milliseconds without notification; 0 disables the watchdog
+ * @param write   Max. average LED write latency in milliseconds; 0 disables this check
+ */
+void nuimo_init_watchdog(unsigned int silence, unsigned int write) {
+  DEBUG_PRINT(("nuimo_init_watchdog\n"));
+
+  my_nuimo->watchdog_silence = silence;
+  my_nuimo->watchdog_write   = write;
+
+  if (!silence) {
+    stop_watchdog();
+  } else if (my_nuimo->cancellable) {
+    start_watchdog();
+  }
+}
+
+
+/**
+ * Assigns the health function. It is called on each transition of the link health.
+ *
+ * @param health_function The function to call; NULL removes the function
+ * @param user_data       Pointer to user data handed over to the health function
+ */
+void nuimo_init_health_function(nuimo_health_function health_function, void *user_data) {
+  DEBUG_PRINT(("nuimo_init_health_function\n"));
+
+  my_nuimo->health_function  = health_function;
+  my_nuimo->health_user_data = user_data;
+}
+
+
+/**
+ * Returns the current link health
+ *
+ * @return The health state based on ::nuimo_health
+ */
+unsigned int nuimo_get_health() {
+  DEBUG_PRINT(("nuimo_get_health\n"));
+
+  return(my_nuimo->health);
+}
+
+
+/**
+ * Disconnects from Nuimo and all characteristics and do some cleanup. The teardown takes at most
+ * NUIMO_TEARDOWN_DEADLINE ms; see ::nuimo_disconnect_deadline.
+ */
+void nuimo_disconnect () {
+  DEBUG_PRINT(("nuimo_disconnect\n"));
+
+  teardown(NUIMO_TEARDOWN_DEADLINE, TRUE);
+}
+
+
+/**
+ * Disconnects from Nuimo and all characteristics and do some cleanup. The calls to BlueZ
+ * (StopDiscovery on all adapters, StopNotify on all characteristics and Disconnect of the Nuimo)
+ * are issued in parallel. The function returns once all of them are answered or the deadline
+ * passed. Calls still outstanding at the deadline are abandoned. Steps which were not required
+ * (e.g. no discovery running) count as completed.
+ *
+ * @param deadline Max. time in milliseconds the teardown may take
+ * @return Mask of the completed steps (see \ref NUIMO_TEARDOWN); NUIMO_TEARDOWN_ALL if all completed
+ */
+unsigned int nuimo_disconnect_deadline (unsigned int deadline) {
+  DEBUG_PRINT(("nuimo_disconnect_deadline\n"));
+
+  return(teardown(deadline, TRUE));
+}
+
+
+/**
+ * Tears the connection down (see ::nuimo_disconnect_deadline). The reconnects of the SDK run
+ * inside main loop callbacks and must not stall the application: they do not wait for the
+ * calls to BlueZ. The calls are sent without waiting for a reply and the proxies are dropped
+ * right away. BlueZ handles them before the Connect of the next attempt, which uses the same
+ * connection to the bus.
+ *
+ * @param deadline Max. time in milliseconds the teardown may take if waiting
+ * @param wait     TRUE to wait for the calls until the deadline
+ * @return Mask of the completed steps (see \ref NUIMO_TEARDOWN); always NUIMO_TEARDOWN_ALL without waiting
+ */
+static unsigned int teardown (unsigned int deadline, gboolean wait) {
+  unsigned int  i = NUIMO_ENTRIES_LEN;
+  GMainContext *context     = NULL;
+  GCancellable *cancellable = NULL;
+  GSource      *timer;
+  gboolean      expired = FALSE;
+
+  DEBUG_PRINT(("teardown\n"));
+
+  NUIMO_TRACE1(connect__state, "disconnected");
+
+  if (my_nuimo->characteristic[NUIMO].connected) {
+    queue_connection_event(NUIMO_CONNECTION_LOST);
+  }
+
+  // A disconnect by the user stops the watchdog and a pending reconnect; a reconnect keeps both
+  if (!my_nuimo->restarting) {
+    my_nuimo->reconnecting = FALSE;
+    my_nuimo->reconnect_at = 0;
+    stop_watchdog();
+    set_health(NUIMO_HEALTH_DOWN);
+  }
+
+  // Pending asynchronous calls must not touch the structure anymore
+  if (my_nuimo->cancellable) {
+    g_cancellable_cancel(my_nuimo->cancellable);
+    g_object_unref(my_nuimo->cancellable);
+    my_nuimo->cancellable = NULL;
+  }
+
+  if (my_nuimo->object_added_sig_hdl) {
+    if (my_nuimo->connection) {
+      g_dbus_connection_signal_unsubscribe(my_nuimo->connection,
+					   my_nuimo->object_added_sig_hdl);
+    } else {
+      g_signal_handler_disconnect(my_nuimo->manager,
+				  my_nuimo->object_added_sig_hdl);
+    }
+    my_nuimo->object_added_sig_hdl = 0;
+  }
+  
+  if (my_nuimo->object_removed_sig_hdl) {
+    if (my_nuimo->connection) {
+      g_dbus_connection_signal_unsubscribe(my_nuimo->connection,
+					   my_nuimo->object_removed_sig_hdl);
+    } else {
+      g_signal_handler_disconnect(my_nuimo->manager,
+				  my_nuimo->object_removed_sig_hdl);
+    }
+    my_nuimo->object_removed_sig_hdl = 0;
+  }
+  
+  // The replies are dispatched on a private context, so nothing else runs in the meantime
+  if (wait) {
+    context     = g_main_context_new();
+    cancellable = g_cancellable_new();
+    g_main_context_push_thread_default(context);
+  }
+  my_nuimo->teardown_pending = 0;
+  my_nuimo->teardown_failed  = 0;
+
+  // In case I'm still looking for the Nuimo
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (my_nuimo->adapter[i].proxy && my_nuimo->adapter[i].discovering) {
+      teardown_call(my_nuimo->adapter[i].proxy, "StopDiscovery", NUIMO_TEARDOWN_DISCOVERY, deadline, cancellable);
+    }
+    my_nuimo->adapter[i].discovering = FALSE;
+  }
+  my_nuimo->active_discovery = FALSE;
+  if (my_nuimo->settle_src) {
+    g_source_remove(my_nuimo->settle_src);
+    my_nuimo->settle_src = 0;
+  }
+  my_nuimo->settling = FALSE;
+
+  // Only the characteristics have notifications and only the Nuimo has to be disconnected
+  for (i = NUIMO; i < NUIMO_ENTRIES_LEN; i++) {
+    if (my_nuimo->characteristic[i].proxy && my_nuimo->characteristic[i].char_sig_hdl) {
+      if (i != NUIMO) {
+	teardown_call(my_nuimo->characteristic[i].proxy, "StopNotify", NUIMO_MASK(i), deadline, cancellable);
+      }
+      disconnect_value_signal(i);
+    }
+    my_nuimo->characteristic[i].notifying = FALSE;
+  }
+  if (my_nuimo->characteristic[NUIMO].proxy) {
+    teardown_call(my_nuimo->characteristic[NUIMO].proxy, "Disconnect", NUIMO_TEARDOWN_DISCONNECT, deadline, cancellable);
+  }
+
+  if (wait) {
+    timer = g_timeout_source_new(deadline);
+    g_source_set_callback(timer, cb_teardown_deadline, &expired, NULL);
+    g_source_attach(timer, context);
+
+    while (my_nuimo->teardown_pending && !expired) {
+      g_main_context_iteration(context, TRUE);
+    }
+
+    // Abandon the outstanding calls; they complete as cancelled right away
+    if (my_nuimo->teardown_pending) {
+      NUIMO_TRACE1(connect__state, "teardown-expired");
+      g_cancellable_cancel(cancellable);
+      while (my_nuimo->teardown_pending) {
+	g_main_context_iteration(context, TRUE);
+      }
+    }
+
+    g_source_destroy(timer);
+    g_source_unref(timer);
+    g_object_unref(cancellable);
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+  }
+
+  for (i = 0; i < my_nuimo->adapters; i++) {
+    if (my_nuimo->adapter[i].proxy) {
+      g_object_unref(my_nuimo->adapter[i].proxy);
+      my_nuimo->adapter[i].proxy = NULL;
+    }
+  }
+
+  i = NUIMO_ENTRIES_LEN;
+  
+  while(i > NUIMO) {
+    i--;
+    
+    if (my_nuimo->characteristic[i].path) {
+      free(my_nuimo->characteristic[i].path);
+      my_nuimo->characteristic[i].path = NULL;
+    }
+    
+    if (my_nuimo->characteristic[i].proxy) {
+      g_object_unref(my_nuimo->characteristic[i].proxy);
+      my_nuimo->characteristic[i].proxy = NULL;
+    }
+  }
+
+  if (my_nuimo->characteristic[BT_ADAPTER].proxy) {
+    g_object_unref(my_nuimo->characteristic[BT_ADAPTER].proxy);
+    my_nuimo->characteristic[BT_ADAPTER].proxy = NULL;
+  }
 
- 
-  vtest[0] = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, pattern, 13, 1);
-  vtest[1] = g_variant_new ("a{sv}", NULL);
-  varled = g_variant_new_tuple(vtest, 2);
+  if (my_nuimo->manager) {
+    if (my_nuimo->wakeup_sig_hdl) {
+      g_signal_handler_disconnect(my_nuimo->manager, my_nuimo->wakeup_sig_hdl);
+      my_nuimo->wakeup_sig_hdl = 0;
+    }
+    g_object_unref(my_nuimo->manager);
+    my_nuimo->manager = NULL;
+  } 
 
-  DBerror = NULL;
-  g_dbus_proxy_call_sync(my_nuimo->characteristic[NUIMO_LED].proxy,
-			 "WriteValue",
-			 varled,
-			 G_DBUS_CALL_FLAGS_NONE,
-			 -1,
-			 NULL,
-			 &DBerror);
-  
-  if(DBerror) {
-    fprintf(stderr, "*EE* Error WriteValue: %s\n", DBerror->message);
-    g_variant_unref(varled);
-    g_variant_unref(vtest[0]);
-    g_variant_unref(vtest[1]);
-    g_error_free(DBerror);
-    return(EXIT_FAILURE);
+  if (my_nuimo->connection) {
+    g_object_unref(my_nuimo->connection);
+    my_nuimo->connection = NULL;
+  }
+  g_free(my_nuimo->bus_owner);
+  my_nuimo->bus_owner = NULL;
+  my_nuimo->characteristic[NUIMO].connected = FALSE;
+  my_nuimo->connecting    = FALSE;
+  my_nuimo->ready         = FALSE;
+  my_nuimo->announced     = FALSE;
+  my_nuimo->connect_start = 0;
+  my_nuimo->widget_busy   = FALSE;
+  my_nuimo->widget_dirty  = FALSE;
+  my_nuimo->frame_expiry  = 0;
+  if (my_nuimo->refresh_src) {
+    g_source_remove(my_nuimo->refresh_src);
+    my_nuimo->refresh_src = 0;
   }
+  state_reset(FALSE);
 
-  return(EXIT_SUCCESS);
+  return(NUIMO_TEARDOWN_ALL & ~my_nuimo->teardown_failed);
 }
 
 
 /**
- * Issue a read value. After the read is done the callback function is issued and returning the requestedd
- * value characteristic indicates wich walue is requested;
+ * Creates the cancellable of the asynchronous calls. The calls still pending on the one of an
+ * earlier init (e.g. a failed one that gets retried) are cancelled before it is released.
+ */
+static void renew_cancellable () {
+  if (my_nuimo->cancellable) {
+    g_cancellable_cancel(my_nuimo->cancellable);
+    g_object_unref(my_nuimo->cancellable);
+  }
+  my_nuimo->cancellable = g_cancellable_new();
+}
+
+
+/**
+ * Initializes the BT stack and start looking for devices like the Nuimo 
  *
- * @param characteristic Defines the characteristic to read from ::nuimo_chars_e
  * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
-*/
-int  nuimo_read_value(const unsigned char characteristic) {
-  GVariant *sendvar;
-  GError   *DBerror;
+ */
+int nuimo_init_bt() {
+  GError *DBerror = NULL;
+  
+  DEBUG_PRINT(("nuimo_init_bt\n"));
 
-  DEBUG_PRINT(("nuimo_read_value\n"));
- 
-  // Adding no flags, but build the structure
-  sendvar = g_variant_new ("(a{sv})", NULL);
+  renew_cancellable();
+  start_watchdog();
 
-  DBerror = NULL;
-  g_dbus_proxy_call_sync(my_nuimo->characteristic[characteristic].proxy,
-			 "ReadValue",
-			 sendvar,
-			 G_DBUS_CALL_FLAGS_NONE,
-			 -1,
-			 NULL,
-			 &DBerror);
-  
-  if(DBerror) {
-    fprintf(stderr, "*EE* Error RedadValue: %s\n", DBerror->message);
-    g_variant_unref(sendvar);
-    g_error_free(DBerror);
-    return(EXIT_FAILURE);
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    if (init_bt_direct() != EXIT_SUCCESS) {
+      return(EXIT_FAILURE);
+    }
+  } else {
+    my_nuimo->manager = g_dbus_object_manager_client_new_for_bus_sync(G_BUS_TYPE_SYSTEM,
+								      G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+								      BT_STACK,
+								      "/",
+								      NULL,
+								      NULL,
+								      NULL,
+								      NULL,
+								      &DBerror);
+    if (!my_nuimo->manager) {
+      fprintf(stderr, "*EE* Error getting object manager client: %s\n", DBerror->message);
+      g_error_free(DBerror);
+      return (EXIT_FAILURE);
+    }
+
+    if (setup_manager() != EXIT_SUCCESS) {
+      return(EXIT_FAILURE);
+    }
   }
 
-  return(EXIT_SUCCESS);
+  start_discovery();
+  
+  return EXIT_SUCCESS;
 }
 
 
 /**
- * Initializes the my_nuimo structure
+ * Initializes the BT stack and start looking for devices like the Nuimo without blocking.
+ * The done function is called once the BT-Adapters are known and the connect or discovery
+ * has been issued. Use the ready function (see ::nuimo_init_ready_function) to learn when
+ * the Nuimo is ready.
  *
- * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ * @param done      Function to call on completion (may be NULL); result is EXIT_SUCCESS or EXIT_FAILURE
+ * @param user_data Pointer to user data handed over to the done function
+ * @return Returns EXIT_FAILURE if the request could not be issued; the done function is not called in this case
  */
-int nuimo_init_status() {
-  unsigned int i;
-
-  DEBUG_PRINT(("nuimo_init_status\n"));
+int nuimo_init_bt_async(nuimo_done_function done, void *user_data) {
+  async_call_s *call;
 
-  my_nuimo = malloc(sizeof(struct nuimo_status_s));
+  DEBUG_PRINT(("nuimo_init_bt_async\n"));
 
-  if (!my_nuimo) {
+  call = malloc(sizeof(async_call_s));
+  if (!call) {
     return(EXIT_FAILURE);
   }
+  call->done           = done;
+  call->user_data      = user_data;
+  call->characteristic = BT_ADAPTER;
+  call->start          = g_get_monotonic_time();
+  call->id             = 0;
 
-  my_nuimo->keyword     = NULL;
-  my_nuimo->value       = NULL;
-  my_nuimo->manager     = NULL;
-  my_nuimo->cb_function = NULL;
-  my_nuimo->user_data   = NULL;
-
-  my_nuimo->object_added_sig_hdl   = 0;
-  my_nuimo->object_removed_sig_hdl = 0;
-  
-  my_nuimo->active_discovery = FALSE;
+  renew_cancellable();
+  start_watchdog();
 
-  i = 0;
-  while (i < NUIMO_ENTRIES_LEN) {
-    my_nuimo->characteristic[i].connected    = FALSE;
-    my_nuimo->characteristic[i].path         = NULL;
-    my_nuimo->characteristic[i].proxy        = NULL;
-    my_nuimo->characteristic[i].char_sig_hdl = 0;
-    i++;
+  if (my_nuimo->bus_mode == NUIMO_BUS_DIRECT) {
+    g_bus_get(G_BUS_TYPE_SYSTEM, my_nuimo->cancellable, cb_bus_ready, call);
+  } else {
+    g_dbus_object_manager_client_new_for_bus(G_BUS_TYPE_SYSTEM,
+					     G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+					     BT_STACK,
+					     "/",
+					     NULL,
+					     NULL,
+					     NULL,
+					     my_nuimo->cancellable,
+					     cb_manager_ready,
+					     call);
   }
 
   return(EXIT_SUCCESS);
@@ -565,211 +4409,259 @@ int nuimo_init_status() {
 
 
 /**
- * Sets Keyword and Value to search for. Useful if more than one Nuimo is in the area
- * In case the Keyword or value is already set it will be deleted
+ * Completes ::nuimo_init_bt_async. On success the discovery is started if the Nuimo is not known yet.
+ * A failed setup during a reconnect schedules the next attempt.
  *
- * @param key The keyword (e.g. "Address")
- * @param val The value you're looking for (e.g. "xx:xx:xx:xx:xx:xx")
-*/
-int nuimo_init_search(const char* key, const char* val) {
-  DEBUG_PRINT(("nuimo_init_search\n"));
-  
-  if (key && val) {
-    if (my_nuimo->keyword) {
-      free(my_nuimo->keyword);
-    }
-    if (my_nuimo->value) {
-      free(my_nuimo->value);
-    }
-    
-    my_nuimo->keyword = malloc(strlen(key) + 1);
-    my_nuimo->value   = malloc(strlen(val) + 1);
-    if (!my_nuimo->keyword || !my_nuimo->value) {
-      return(EXIT_FAILURE);
-    }
-    
-    strcpy(my_nuimo->keyword, key);
-    strcpy(my_nuimo->value,   val);
+ * @param call      The ::async_call_s of the setup
+ * @param result    EXIT_SUCCESS or EXIT_FAILURE
+ * @param cancelled TRUE if the setup got cancelled by ::nuimo_disconnect
+ */
+static void init_done (void *call, int result, gboolean cancelled) {
+  async_call_s *setup = call;
+
+  DEBUG_PRINT(("init_done\n"));
+
+  if (result == EXIT_SUCCESS) {
+    start_discovery();
+  } else if (!cancelled && my_nuimo->reconnecting) {
+    schedule_reconnect();
   }
-  
-  return(EXIT_SUCCESS);
+
+  if (setup->done) {
+    setup->done(result, NULL, 0, setup->user_data);
+  }
+  free(setup);
 }
 
+
 /**
- * Assigns the callback function for the user. The function must receive three values:
- * void cb_function(uint characteristic, int value, uint direction) with the following parameters:
- * \n \n 
- * characteristic The identifier (see ::characteristic_s) \n 
- * value          The value of movement. In case of SWIPE/TOUCH the value is 0 \n 
- * direction      Informs you about direction of movement. In case of BUTTON and BATTERY events the value is 0
+ * The object manager of ::nuimo_init_bt_async is ready (NUIMO_BUS_MANAGER mode)
+ *
+ * @param source    Not used
+ * @param res       The result of the creation
+ * @param user_data The ::async_call_s of the setup
  */
-void nuimo_init_cb_function(void *cb_function, void *user_data) {
-  DEBUG_PRINT(("nuimo_init_cb_function\n"));
-  
-  my_nuimo->cb_function = cb_function;
-  my_nuimo->user_data = user_data;
+static void cb_manager_ready (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GDBusObjectManager *manager;
+  GError             *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_manager_ready\n"));
+
+  manager = g_dbus_object_manager_client_new_for_bus_finish(res, &DBerror);
+  if (!manager) {
+    if (g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free(DBerror);
+      init_done(user_data, EXIT_FAILURE, TRUE);
+      return;
+    }
+    fprintf(stderr, "*EE* Error getting object manager client: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    init_done(user_data, EXIT_FAILURE, FALSE);
+    return;
+  }
+
+  my_nuimo->manager = manager;
+  init_done(user_data, setup_manager(), FALSE);
 }
 
 
 /**
- * Disconnects from Nuimo and all characteristics and do some cleanup.
+ * The system bus of ::nuimo_init_bt_async is ready (NUIMO_BUS_DIRECT mode). Subscribes the
+ * signals and asks for the unique name of BlueZ.
+ *
+ * @param source    Not used
+ * @param res       The result of the connection
+ * @param user_data The ::async_call_s of the setup
  */
-void nuimo_disconnect () {
-  unsigned int i = NUIMO_ENTRIES_LEN;
+static void cb_bus_ready (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GDBusConnection *connection;
+  GError          *DBerror = NULL;
 
-  DEBUG_PRINT(("nuimo_disconnect\n"));
+  DEBUG_PRINT(("cb_bus_ready\n"));
 
-  if (my_nuimo->object_added_sig_hdl) {
-    g_signal_handler_disconnect(my_nuimo->manager,
-				my_nuimo->object_added_sig_hdl);
-    my_nuimo->object_added_sig_hdl = 0;
-  }
-  
-  if (my_nuimo->object_removed_sig_hdl) {
-    g_signal_handler_disconnect(my_nuimo->manager,
-				my_nuimo->object_removed_sig_hdl);
-    my_nuimo->object_removed_sig_hdl = 0;
-  }
-  
-  // In case I'm still looking for the Nuimo
-  if (my_nuimo->manager &&  my_nuimo->active_discovery) {
-    g_dbus_proxy_call_sync(my_nuimo->characteristic[BT_ADAPTER].proxy,
-			   "StopDiscovery",
-			   NULL,
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   NULL,
-			   NULL);
+  connection = g_bus_get_finish(res, &DBerror);
+  if (!connection) {
+    if (g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free(DBerror);
+      init_done(user_data, EXIT_FAILURE, TRUE);
+      return;
+    }
+    fprintf(stderr, "*EE* Error getting the system bus: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    init_done(user_data, EXIT_FAILURE, FALSE);
+    return;
   }
-  my_nuimo->active_discovery = FALSE;
-  
-  while(i > NUIMO) {
-    i--;
-    
-    if (my_nuimo->characteristic[i].path) {
-      free(my_nuimo->characteristic[i].path);
-      my_nuimo->characteristic[i].path = NULL;
+
+  my_nuimo->connection = connection;
+  subscribe_direct();
+
+  g_dbus_connection_call(my_nuimo->connection,
+			 "org.freedesktop.DBus",
+			 "/org/freedesktop/DBus",
+			 "org.freedesktop.DBus",
+			 "GetNameOwner",
+			 g_variant_new("(s)", BT_STACK),
+			 G_VARIANT_TYPE("(s)"),
+			 G_DBUS_CALL_FLAGS_NONE,
+			 -1,
+			 my_nuimo->cancellable,
+			 cb_owner_ready,
+			 user_data);
+}
+
+
+/**
+ * The unique name of BlueZ is known (NUIMO_BUS_DIRECT mode). Reads the objects of BlueZ.
+ *
+ * @param source    The system bus
+ * @param res       The result of GetNameOwner
+ * @param user_data The ::async_call_s of the setup
+ */
+static void cb_owner_ready (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *result;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_owner_ready\n"));
+
+  result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &DBerror);
+  if (!result) {
+    if (g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free(DBerror);
+      init_done(user_data, EXIT_FAILURE, TRUE);
+      return;
     }
-    
-    if (my_nuimo->characteristic[i].proxy) {
-      if (my_nuimo->characteristic[i].char_sig_hdl) {
+    fprintf(stderr, "*EE* Error GetNameOwner: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    init_done(user_data, EXIT_FAILURE, FALSE);
+    return;
+  }
+  g_variant_get(result, "(s)", &my_nuimo->bus_owner);
+  g_variant_unref(result);
 
-	g_dbus_proxy_call_sync(my_nuimo->characteristic[i].proxy,
-			       "StopNotify",
-			       NULL,
-			       G_DBUS_CALL_FLAGS_NONE,
-			       -1,
-			       NULL,
-			       NULL);
-	
-	g_signal_handler_disconnect(my_nuimo->characteristic[i].proxy,
-				    my_nuimo->characteristic[i].char_sig_hdl);
-	my_nuimo->characteristic[i].char_sig_hdl = 0;
-      }
+  g_dbus_connection_call(my_nuimo->connection,
+			 my_nuimo->bus_owner,
+			 "/",
+			 "org.freedesktop.DBus.ObjectManager",
+			 "GetManagedObjects",
+			 NULL,
+			 G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+			 G_DBUS_CALL_FLAGS_NONE,
+			 -1,
+			 my_nuimo->cancellable,
+			 cb_objects_ready,
+			 user_data);
+}
 
-      g_dbus_proxy_call_sync(my_nuimo->characteristic[i].proxy,
-			     "Disconnect",
-			     NULL,
-			     G_DBUS_CALL_FLAGS_NONE,
-			     -1,
-			     NULL,
-			     NULL);
-      my_nuimo->characteristic[i].proxy = NULL;
+
+/**
+ * The objects of BlueZ are known (NUIMO_BUS_DIRECT mode). Takes over the BT-Adapters and the Nuimo.
+ *
+ * @param source    The system bus
+ * @param res       The result of GetManagedObjects
+ * @param user_data The ::async_call_s of the setup
+ */
+static void cb_objects_ready (GObject *source, GAsyncResult *res, gpointer user_data) {
+  GVariant *result;
+  GVariant *objects;
+  GError   *DBerror = NULL;
+
+  DEBUG_PRINT(("cb_objects_ready\n"));
+
+  result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &DBerror);
+  if (!result) {
+    if (g_error_matches(DBerror, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free(DBerror);
+      init_done(user_data, EXIT_FAILURE, TRUE);
+      return;
     }
+    fprintf(stderr, "*EE* Error GetManagedObjects: %s\n", DBerror->message);
+    g_error_free(DBerror);
+    init_done(user_data, EXIT_FAILURE, FALSE);
+    return;
   }
 
-  if (my_nuimo->manager) {
-    g_object_unref(my_nuimo->manager);
-    my_nuimo->manager = NULL;
-  } 
-  my_nuimo->characteristic[NUIMO].connected = FALSE;
+  objects = g_variant_get_child_value(result, 0);
+  g_variant_unref(result);
+
+  init_done(user_data, setup_direct(objects), FALSE);
+  g_variant_unref(objects);
 }
 
 
 /**
- * Initializes the BT stack and start looking for devices like the Nuimo 
+ * Takes over the BT-Adapters and the Nuimo (if already known) from the object manager
+ * (NUIMO_BUS_MANAGER mode)
  *
- * @return Returns EXIT_SUCCESS or EXIT_FAILURE depending if the request was successful or not
+ * @return EXIT_SUCCESS or EXIT_FAILURE
  */
-int nuimo_init_bt() {
-  GError         *DBerror = NULL;
+static int setup_manager () {
   GList          *objects;
   GList          *ob_list;
   GDBusInterface *interface;
-  
-  DEBUG_PRINT(("nuimo_init_bt\n"));
+  GDBusObject    *object;
+
+  DEBUG_PRINT(("setup_manager\n"));
 
-  my_nuimo->manager = g_dbus_object_manager_client_new_for_bus_sync(G_BUS_TYPE_SYSTEM,
-								    G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
-								    BT_STACK,
-								    "/",
-								    NULL,
-								    NULL,
-								    NULL,
-								    NULL,
-								    &DBerror);
-  if (!my_nuimo->manager) {
-    fprintf(stderr, "*EE* Error getting object manager client: %s\n", DBerror->message);
-    g_error_free(DBerror);
-    return (EXIT_FAILURE);
-  }
-  
   my_nuimo->object_added_sig_hdl = g_signal_connect (my_nuimo->manager,
 						     "object-added",
 						     G_CALLBACK (cb_object_added),
 						     NULL);
+  my_nuimo->wakeup_sig_hdl = g_signal_connect (my_nuimo->manager,
+					       "interface-proxy-properties-changed",
+					       G_CALLBACK (cb_manager_properties_changed),
+					       NULL);
 
   objects = g_dbus_object_manager_get_objects(my_nuimo->manager);
 
-  // First look for the BT-Adapter.
+  // First collect all BT-Adapters. Known adapters keep their entry (and counters)
   for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
     
     interface = g_dbus_object_get_interface (ob_list->data, BT_ADAPTER_NAME);
     if(interface) {
-      my_nuimo->characteristic[BT_ADAPTER].proxy = G_DBUS_PROXY (interface);
-
-      break;
+      add_adapter(g_dbus_object_get_object_path(ob_list->data), G_DBUS_PROXY (interface));
     }
   }
 
-  if (!my_nuimo->characteristic[BT_ADAPTER].proxy) {
+  if (check_adapters() != EXIT_SUCCESS) {
+    g_list_free_full(objects, g_object_unref);
     return EXIT_FAILURE;
   }
 
-  // If successful, run a second loop and check if the Nuimo is already known
-  for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
-    connect_nuimo(my_nuimo->manager, ob_list->data);
-    if (my_nuimo->characteristic[NUIMO].connected) {
-      break;
-    }
-  }
-  
-  if (my_nuimo->characteristic[NUIMO].connected) {
-    for (ob_list = objects; ob_list != NULL; ob_list = ob_list->next) {
-      get_characteristics(my_nuimo->manager, ob_list->data);
-    }
+  // If successful, check if the Nuimo is already known.
+  // The characteristics are collected as soon as the connection is established (see cb_connect_done)
+  object = select_nuimo(objects);
+  if (object) {
+    connect_nuimo(my_nuimo->manager, object);
   }
+  g_list_free_full(objects, g_object_unref);
 
-  
-  // if the Nuimo is not in the list, start looking activley
-  if (!my_nuimo->characteristic[NUIMO].connected && !my_nuimo->active_discovery) {
-    DBerror = NULL;
-    g_dbus_proxy_call_sync( my_nuimo->characteristic[BT_ADAPTER].proxy,
-			    "StartDiscovery",
-			    NULL,
-			    G_DBUS_CALL_FLAGS_NONE,
-			    -1,
-			    NULL,
-			    &DBerror);
-
-
-    if(DBerror) {
-      fprintf(stderr, "*EE* Error StartDiscovery: %s\n", DBerror->message);
-      g_error_free(DBerror);
-      return (EXIT_FAILURE);
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * If the Nuimo is not known yet, starts looking actively on all allowed adapters in parallel
+ */
+static void start_discovery () {
+  unsigned int i;
+
+  DEBUG_PRINT(("start_discovery\n"));
+
+  if (!my_nuimo->connecting && !my_nuimo->active_discovery) {
+    for (i = 0; i < my_nuimo->adapters; i++) {
+      if (adapter_allowed(i)) {
+	g_dbus_proxy_call(my_nuimo->adapter[i].proxy,
+			  "StartDiscovery",
+			  NULL,
+			  G_DBUS_CALL_FLAGS_NONE,
+			  -1,
+			  my_nuimo->cancellable,
+			  cb_call_done,
+			  "StartDiscovery");
+	my_nuimo->adapter[i].discovering = TRUE;
+      }
     }
     my_nuimo->active_discovery = TRUE;
+    NUIMO_TRACE1(connect__state, "discovering");
   }
-  
-  return EXIT_SUCCESS;
 }
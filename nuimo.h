@@ -7,6 +7,10 @@
 #include <errno.h>
 #include <gio/gio.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 /**
  * Debug-printouts in case the compiler has the option -DDEBUG or 'make debug' is used.
@@ -72,9 +76,75 @@ enum nuimo_swipe {
   NUIMO_LONG_TOUCH_BOTTOM,  
   NUIMO_SWIPE_LEN,     
 };
+
+/**
+ * Directions of the connection state events (characteristic NUIMO). They are delivered to the
+ * batch function and the handlers, but not to the old style callback.
+ */
+enum nuimo_connection {
+  NUIMO_CONNECTION_LOST = 0,
+  NUIMO_CONNECTION_READY,
+  NUIMO_CONNECTION_LEN
+};
+
+#define NUIMO_DIRECTION_ANY 0xFFFFFFFFu  /// Handler filter matching all directions (see ::nuimo_add_handler)
+#define NUIMO_BINDING_DIRECTIONS NUIMO_SWIPE_LEN  /// Number of directions of each characteristic in the binding table
+/** @} */
+
+
+/**
+ * @defgroup NUIMO_WIDGETS LED widgets
+ * Widgets are bound to a characteristic with ::nuimo_bind_widget. The library keeps the value and
+ * renders it to the LED matrix without a round trip through the application.
+ * @{
+ */
+enum nuimo_widget {
+  NUIMO_WIDGET_NONE = 0,  /// No widget bound
+  NUIMO_WIDGET_BAR,       /// Level bar filled from left to right
+  NUIMO_WIDGET_RING,      /// Ring around the matrix filled clockwise
+  NUIMO_WIDGET_NUMBER,    /// The value as number (0...99)
+  NUIMO_WIDGET_SWITCH,    /// On (value > min) or off
+  NUIMO_WIDGET_LEN
+};
+
+#define NUIMO_WIDGET_BRIGHTNESS 0x80  /// Brightness used to display widgets
+#define NUIMO_WIDGET_TIMEOUT    20    /// Display time of widgets (2 seconds)
+/** @} */
+
+
+/**
+ * @defgroup NUIMO_HEALTH Link health
+ * States of the link-health watchdog (see ::nuimo_init_watchdog)
+ * @{
+ */
+enum nuimo_health {
+  NUIMO_HEALTH_DOWN = 0,        /// Not connected
+  NUIMO_HEALTH_OK,              /// Connected and all notifications armed
+  NUIMO_HEALTH_SLOW,            /// LED writes take longer than the threshold
+  NUIMO_HEALTH_PROBING,         /// No notification for too long; probing the link with a read
+  NUIMO_HEALTH_RESUBSCRIBING,   /// Re-arming the notifications
+  NUIMO_HEALTH_RECONNECTING,    /// Waiting for the next reconnect attempt
+  NUIMO_HEALTH_LEN
+};
 /** @} */
 
 
+/**
+ * @defgroup NUIMO_BUS_MODES Bus modes
+ * How the SDK follows the objects of BlueZ (see ::nuimo_init_bus_mode)
+ * @{
+ */
+enum nuimo_bus_mode {
+  NUIMO_BUS_MANAGER = 0,  /// Object manager caching the complete BlueZ tree
+  NUIMO_BUS_DIRECT,       /// Signals scoped to the Nuimo; no property cache
+  NUIMO_BUS_LEN
+};
+/** @} */
+
+
+#define NUIMO_ADAPTERS_MAX 8  /// Maximum number of BT-Adapters handled
+
+
 /**
  * This is the master order of the individual devices/characteristics.
  * All arrays are based on this order. Please use it instead of fixed values.
@@ -92,16 +162,183 @@ enum nuimo_chars_e {
 };
 
 
+/**
+ * @defgroup NUIMO_MASKS Subscription masks
+ * Used by ::nuimo_set_subscription to select the characteristics sending notifications.
+ * @{
+ */
+#define NUIMO_MASK(characteristic) (1u << (characteristic))
+#define NUIMO_MASK_ALL             (NUIMO_MASK(NUIMO_BATTERY) | NUIMO_MASK(NUIMO_BUTTON) | NUIMO_MASK(NUIMO_FLY) | \
+                                    NUIMO_MASK(NUIMO_SWIPE)   | NUIMO_MASK(NUIMO_ROTATION))
+/** @} */
+
+
+/**
+ * @defgroup NUIMO_TEARDOWN Steps of the teardown
+ * Returned by ::nuimo_disconnect_deadline. The StopNotify of a characteristic is reported by its
+ * NUIMO_MASK.
+ * @{
+ */
+#define NUIMO_TEARDOWN_DISCOVERY  NUIMO_MASK(BT_ADAPTER) /// StopDiscovery on all adapters
+#define NUIMO_TEARDOWN_DISCONNECT NUIMO_MASK(NUIMO)      /// Disconnect of the Nuimo
+#define NUIMO_TEARDOWN_ALL        (NUIMO_TEARDOWN_DISCOVERY | NUIMO_TEARDOWN_DISCONNECT | NUIMO_MASK_ALL)
+#define NUIMO_TEARDOWN_DEADLINE   2000                   /// Deadline in ms used by ::nuimo_disconnect
+/** @} */
+
+
+/**
+ * Compact snapshot of the current Nuimo state. The library keeps this block up to date while
+ * decoding the notifications. Use ::nuimo_get_state to get a consistent copy from any thread.
+ */
+struct nuimo_state_s {
+  unsigned int connected;   /// TRUE while the Nuimo is connected
+  unsigned int button;      /// Last button direction (see ::nuimo_button)
+  unsigned int swipe;       /// Last swipe/touch direction (see ::nuimo_swipe)
+  unsigned int fly;         /// Last fly direction (see ::nuim_fly)
+  int          fly_value;   /// Last fly value
+  int          battery;     /// Last battery level in percent; -1 until the first value is received
+  gint64       rotation;    /// Accumulated rotation since connect
+  guint64      updates;     /// Number of decoded notifications since connect
+};
+
+
+/**
+ * Counters to measure the load caused by the Nuimo. Use ::nuimo_get_stats to read them.
+ */
+struct nuimo_stats_s {
+  guint64 notifications;      /// Number of received property change signals (each one wakes up the process)
+  guint64 events;             /// Number of decoded events
+  guint64 batches;            /// Number of delivered event batches
+  gint64  connect_time;       /// Time in microseconds from issuing Connect until the Nuimo was connected
+  gint64  ready_time;         /// Time in microseconds from issuing Connect until all notifications were armed
+  guint64 widget_writes;      /// Number of LED writes issued by widgets
+  gint64  widget_latency;     /// Time in microseconds from the last input event until its widget frame was written
+  gint64  widget_latency_max; /// Maximum of widget_latency
+  guint64 merged;             /// Continuous events merged into a pending one
+  gint64  button_latency;     /// Time in microseconds from the arrival of the last button event until its delivery
+  gint64  button_latency_max; /// Maximum of button_latency
+  gint64  notify_interval;    /// Average time in microseconds between two notifications
+  gint64  write_latency;      /// Average LED write latency in microseconds
+  guint64 probes;             /// Number of probe reads issued by the watchdog
+  guint64 resubscribes;       /// Number of times the watchdog re-armed the notifications
+  guint64 reconnects;         /// Number of reconnects scheduled by the watchdog or after a failed Connect
+  guint64 refreshes;          /// Number of refreshes of the persistent LED frame
+  guint64 skipped_writes;     /// Number of redundant LED writes skipped in persistent mode
+  guint64 actions;            /// Number of actions called through the binding table
+  guint64 wakeups;            /// Number of D-Bus signals received incl. those of other devices (each one wakes up the process)
+};
+
+
+/**
+ * Maximum number of raw payload bytes stored in ::nuimo_event
+ */
+#define NUIMO_EVENT_RAW_LEN 20
+
+/**
+ * One decoded Nuimo event. The library collects all events arriving in one main loop iteration
+ * and hands them over as one batch to the function installed with ::nuimo_init_batch_function.
+ * Discrete events come first. Continuous events (rotation, fly up/down, battery) waiting for the
+ * dispatch are merged: the rotation values are summed up, otherwise the latest value is kept.
+ * A merged event has the arrival time of the oldest and the sequence number and raw payload of
+ * the latest event. Events arriving with and without the button held are not merged.
+ */
+typedef struct nuimo_event_s {
+  unsigned int  characteristic;            /// The characteristic based on ::nuimo_chars_e
+  int           value;                     /// Decoded value (in case of SWIPE/TOUCH events the value is 0)
+  unsigned int  direction;                 /// Direction of the event based on \ref NUIMO_DIRECTIONS
+  gint64        timestamp;                 /// Arrival time in microseconds (g_get_monotonic_time)
+  guint64       sequence;                  /// Sequence number; increases by one for every event of the device
+  unsigned char held;                      /// TRUE if the button was held when the event arrived (FALSE for button events)
+  unsigned char raw_len;                   /// Number of valid bytes in raw
+  unsigned char raw[NUIMO_EVENT_RAW_LEN];  /// Raw payload as received from the Nuimo
+} nuimo_event;
+
+/**
+ * Per-adapter statistics (see ::nuimo_get_adapter_stats)
+ */
+struct nuimo_adapter_stats_s {
+  char     path[64];  /// D-Bus path of the adapter (e.g. /org/bluez/hci0)
+  gboolean present;   /// TRUE if the adapter is present
+  gboolean in_use;    /// TRUE if the Nuimo is connected through this adapter
+  guint    devices;   /// Number of connected devices
+  guint64  events;    /// Events received through this adapter
+  guint64  writes;    /// LED writes sent through this adapter
+};
+
+
+/**
+ * Batch callback function. Receives an array of count events in arrival order.
+ */
+typedef void (*nuimo_batch_function)(const nuimo_event *events, unsigned int count, void *user_data);
+
+/**
+ * Ready callback function. Called once the Nuimo is connected and all notifications are armed.
+ */
+typedef void (*nuimo_ready_function)(void *user_data);
+
+/**
+ * Health callback function. Called on each transition of the link health (see \ref NUIMO_HEALTH).
+ */
+typedef void (*nuimo_health_function)(unsigned int old_health, unsigned int new_health, void *user_data);
+
+/**
+ * Handler function registered with ::nuimo_add_handler for one characteristic
+ */
+typedef void (*nuimo_handler_function)(const nuimo_event *event, void *user_data);
+
+/**
+ * Action function called for each event bound by ::nuimo_load_bindings. action and argument are
+ * taken from the config.
+ */
+typedef void (*nuimo_action_function)(const char *action, int argument, const nuimo_event *event, void *user_data);
+
+/**
+ * Completion function of the asynchronous calls. result is EXIT_SUCCESS or EXIT_FAILURE;
+ * data and len hold the received bytes of a read (NULL/0 otherwise).
+ */
+typedef void (*nuimo_done_function)(int result, const unsigned char *data, unsigned int len, void *user_data);
+
+
 // public functions
 void nuimo_print_status ();
 int  nuimo_init_bt ();
+int  nuimo_init_bt_async(nuimo_done_function done, void *user_data);
 int  nuimo_init_search (const char* key, const char* val);
+int  nuimo_init_adapter(const char *adapter);
+int  nuimo_init_bus_mode(unsigned int mode);
 void nuimo_init_cb_function(void *cb_function, void *user_data);
+void nuimo_init_batch_function(nuimo_batch_function batch_function, void *user_data);
+unsigned int nuimo_add_handler(unsigned int characteristic, unsigned int direction, nuimo_handler_function function, void *user_data);
+int  nuimo_remove_handler(unsigned int id);
+int  nuimo_load_bindings(const char *config);
+int  nuimo_load_bindings_file(const char *filename);
+void nuimo_init_action_function(nuimo_action_function action_function, void *user_data);
+void nuimo_init_ready_function(nuimo_ready_function ready_function, void *user_data);
+void nuimo_init_health_function(nuimo_health_function health_function, void *user_data);
+void nuimo_init_watchdog(unsigned int silence, unsigned int write);
+unsigned int nuimo_get_health();
 int  nuimo_init_status ();
 void nuimo_disconnect ();
+unsigned int nuimo_disconnect_deadline (unsigned int deadline);
 int  nuimo_set_led(const unsigned char* bitmap, const unsigned char brightness, const unsigned char timeout, const unsigned char mode);
 int  nuimo_set_icon(const unsigned char, const unsigned char brightness, const unsigned char timeout, const unsigned char mode);
 int  nuimo_read_value(const unsigned char characteristic);
+int  nuimo_set_led_async(const unsigned char* bitmap, const unsigned char brightness, const unsigned char timeout, const unsigned char mode,
+			 nuimo_done_function done, void *user_data);
+int  nuimo_set_icon_async(const unsigned char icon, const unsigned char brightness, const unsigned char timeout, const unsigned char mode,
+			  nuimo_done_function done, void *user_data);
+void nuimo_set_persistent(gboolean persistent);
+int  nuimo_read_value_async(const unsigned char characteristic, nuimo_done_function done, void *user_data);
+int  nuimo_get_state(struct nuimo_state_s *state);
+int  nuimo_set_subscription(unsigned int mask);
+void nuimo_get_stats(struct nuimo_stats_s *stats);
+unsigned int nuimo_get_adapter_stats(struct nuimo_adapter_stats_s *stats, unsigned int max);
+int  nuimo_bind_widget(unsigned int characteristic, unsigned int widget, int min, int max, int value, int step);
+int  nuimo_get_widget_value(unsigned int characteristic);
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,296 @@
+#ifndef _NUIMO_HPP
+#define _NUIMO_HPP
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "nuimo.h"
+
+
+/**
+ * Header-only C++20 binding of the Nuimo SDK.
+ * \n \n
+ * nuimo::device is a move-only handle; it initializes the SDK and disconnects on destruction.
+ * Event handlers are dispatched through templates (one indirect call per batch, no std::function
+ * or virtual call per event). Connect, LED writes and reads are awaitables completing on the
+ * GLib main loop without blocking a thread:
+ *
+ * \code
+ * nuimo::task run(nuimo::device &nuimo) {
+ *   co_await nuimo.connect();
+ *   co_await nuimo.set_icon(1, 0x80, 50, 1);
+ *   nuimo::result battery = co_await nuimo.read(NUIMO_BATTERY);
+ * }
+ * \endcode
+ *
+ * The SDK handles one Nuimo per process, so only one device handle may exist at a time.
+ * Awaitables still pending when the device is released are detached: their coroutine is not
+ * resumed anymore and stays suspended.
+ */
+namespace nuimo {
+
+namespace detail {
+/**
+ * Counts the released devices. Awaitables remember it when suspending and do not resume the
+ * coroutine if a device was released meanwhile (the SDK handles one Nuimo per process).
+ */
+inline unsigned int session = 0;
+}
+
+/**
+ * Result of an asynchronous operation
+ */
+struct result {
+  int                        status = EXIT_FAILURE;  /// EXIT_SUCCESS or EXIT_FAILURE
+  std::vector<unsigned char> data;                   /// Received bytes of a read
+};
+
+
+/**
+ * Awaitable wrapping one of the asynchronous SDK calls. Start is a callable issuing the call
+ * with the given done function and user data.
+ */
+template <class Start>
+class operation {
+public:
+  explicit operation(Start start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_  = handle;
+    session_ = detail::session;
+    // Do not suspend if the call could not be issued
+    return start_(&operation::done, this) == EXIT_SUCCESS;
+  }
+
+  result await_resume() { return std::move(result_); }
+
+private:
+  static void done(int status, const unsigned char *data, unsigned int len, void *user_data) {
+    operation *self = static_cast<operation*>(user_data);
+
+    // Detached by the release of the device (the call was cancelled)
+    if (self->session_ != detail::session) {
+      return;
+    }
+    self->result_.status = status;
+    if (data) {
+      self->result_.data.assign(data, data + len);
+    }
+    self->handle_.resume();
+  }
+
+  Start                   start_;
+  std::coroutine_handle<> handle_;
+  unsigned int            session_ = 0;
+  result                  result_;
+};
+
+
+/**
+ * Awaitable completing once the Nuimo is connected and all notifications are armed. The setup
+ * runs asynchronously; the result is EXIT_FAILURE if it fails or the link drops before the
+ * Nuimo got ready. Readiness is observed through the NUIMO_CONNECTION_READY event, so the ready
+ * function of the application is left alone.
+ */
+class connect_operation {
+public:
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_  = handle;
+    session_ = detail::session;
+    ready_   = nuimo_add_handler(NUIMO, NUIMO_CONNECTION_READY, &connect_operation::ready, this);
+    lost_    = nuimo_add_handler(NUIMO, NUIMO_CONNECTION_LOST, &connect_operation::lost, this);
+    if (nuimo_init_bt_async(&connect_operation::started, this) != EXIT_SUCCESS) {
+      release();
+      return false;
+    }
+    return true;
+  }
+
+  int await_resume() const noexcept { return status_; }
+
+private:
+  static void started(int status, const unsigned char*, unsigned int, void *user_data) {
+    if (status != EXIT_SUCCESS) {
+      static_cast<connect_operation*>(user_data)->complete(EXIT_FAILURE);
+    }
+  }
+
+  static void ready(const nuimo_event*, void *user_data) {
+    static_cast<connect_operation*>(user_data)->complete(EXIT_SUCCESS);
+  }
+
+  static void lost(const nuimo_event*, void *user_data) {
+    static_cast<connect_operation*>(user_data)->complete(EXIT_FAILURE);
+  }
+
+  void release() {
+    if (ready_) {
+      nuimo_remove_handler(ready_);
+      ready_ = 0;
+    }
+    if (lost_) {
+      nuimo_remove_handler(lost_);
+      lost_ = 0;
+    }
+  }
+
+  void complete(int status) {
+    release();
+    // Detached by the release of the device
+    if (session_ != detail::session) {
+      return;
+    }
+    status_ = status;
+    handle_.resume();
+  }
+
+  std::coroutine_handle<> handle_;
+  unsigned int            session_ = 0;
+  unsigned int            ready_   = 0;
+  unsigned int            lost_    = 0;
+  int                     status_  = EXIT_FAILURE;
+};
+
+
+/**
+ * Minimal fire-and-forget coroutine type to run the awaitables from the GLib main loop
+ */
+struct task {
+  struct promise_type {
+    task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+
+/**
+ * Move-only handle of the Nuimo. Disconnects on destruction.
+ */
+class device {
+public:
+  device() : active_(nuimo_init_status() == EXIT_SUCCESS) {}
+
+  /**
+   * The handle is inactive (see operator bool) if the search could not be set.
+   *
+   * @param key The keyword to search for (e.g. "Address")
+   * @param val The value you're looking for (e.g. "xx:xx:xx:xx:xx:xx")
+   */
+  device(const char *key, const char *val) : device() {
+    if (active_ && nuimo_init_search(key, val) != EXIT_SUCCESS) {
+      release();
+    }
+  }
+
+  device(const device&)            = delete;
+  device& operator=(const device&) = delete;
+
+  device(device &&other) noexcept
+    : active_(std::exchange(other.active_, false)), batch_(std::exchange(other.batch_, false)) {}
+
+  device& operator=(device &&other) noexcept {
+    if (this != &other) {
+      release();
+      active_ = std::exchange(other.active_, false);
+      batch_  = std::exchange(other.batch_, false);
+    }
+    return *this;
+  }
+
+  ~device() { release(); }
+
+  explicit operator bool() const noexcept { return active_; }
+
+  /**
+   * Calls handler(const nuimo_event&) for each event. The handler must outlive the registration.
+   */
+  template <class Handler>
+  void on_event(Handler &handler) {
+    nuimo_init_batch_function(&device::dispatch_event<Handler>, &handler);
+    batch_ = true;
+  }
+
+  /**
+   * Calls handler(const nuimo_event*, unsigned int) once per batch
+   */
+  template <class Handler>
+  void on_batch(Handler &handler) {
+    nuimo_init_batch_function(&device::dispatch_batch<Handler>, &handler);
+    batch_ = true;
+  }
+
+  connect_operation connect() { return {}; }
+
+  auto set_led(const std::array<unsigned char, 11> &bitmap, unsigned char brightness, unsigned char timeout, unsigned char mode) {
+    return make_operation([=](nuimo_done_function done, void *user_data) {
+      return nuimo_set_led_async(bitmap.data(), brightness, timeout, mode, done, user_data);
+    });
+  }
+
+  auto set_icon(unsigned char icon, unsigned char brightness, unsigned char timeout, unsigned char mode) {
+    return make_operation([=](nuimo_done_function done, void *user_data) {
+      return nuimo_set_icon_async(icon, brightness, timeout, mode, done, user_data);
+    });
+  }
+
+  auto read(unsigned char characteristic) {
+    return make_operation([=](nuimo_done_function done, void *user_data) {
+      return nuimo_read_value_async(characteristic, done, user_data);
+    });
+  }
+
+  nuimo_state_s state() const {
+    nuimo_state_s state;
+
+    nuimo_get_state(&state);
+    return state;
+  }
+
+private:
+  template <class Start>
+  static operation<Start> make_operation(Start start) { return operation<Start>(std::move(start)); }
+
+  template <class Handler>
+  static void dispatch_event(const nuimo_event *events, unsigned int count, void *user_data) {
+    Handler &handler = *static_cast<Handler*>(user_data);
+
+    for (unsigned int i = 0; i < count; i++) {
+      handler(events[i]);
+    }
+  }
+
+  template <class Handler>
+  static void dispatch_batch(const nuimo_event *events, unsigned int count, void *user_data) {
+    (*static_cast<Handler*>(user_data))(events, count);
+  }
+
+  void release() {
+    if (active_) {
+      // Only remove the batch function installed through this handle
+      if (batch_) {
+        nuimo_init_batch_function(NULL, NULL);
+        batch_ = false;
+      }
+      detail::session++;
+      nuimo_disconnect();
+      active_ = false;
+    }
+  }
+
+  bool active_;
+  bool batch_ = false;  /// true if on_event() or on_batch() installed the batch function
+};
+
+}
+
+#endif
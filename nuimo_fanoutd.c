@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <glib-unix.h>
+
+#include "nuimo.h"
+#include "nuimo_ring.h"
+
+/**
+ * Maximum length of one command line received on the socket
+ */
+#define CMD_LEN 128
+
+/**
+ * Holds the state of one connected command client. While a command waits for the Nuimo the
+ * socket is not watched, so the client stays valid and the replies keep the order of the commands.
+ */
+typedef struct {
+  int          fd;            /// Socket of the client
+  unsigned int len;           /// Number of bytes in buf
+  char         buf[CMD_LEN];  /// Received, not yet processed bytes
+}client_s;
+
+// prototypes for private functions
+static gboolean cb_termination (gpointer data);
+static void     publish_batch (const nuimo_event *events, unsigned int count, void *user_data);
+static int      execute_command (char *line, client_s *client);
+static void     cb_command_done (int result, const unsigned char *data, unsigned int len, void *user_data);
+static void     reply (client_s *client, const char *text);
+static gboolean next_command (client_s *client);
+static gboolean cb_client (gint fd, GIOCondition condition, gpointer user_data);
+static gboolean cb_accept (gint fd, GIOCondition condition, gpointer user_data);
+
+
+/**
+ * Stops the g_main_loop; call this function to stop the daemon
+ *
+ * @param data Is the g_main_loop handle returnes by ::g_main_loop_new
+ */
+static gboolean cb_termination (gpointer data) {
+  DEBUG_PRINT(("cb_termination\n"));
+
+  g_main_loop_quit(data);
+
+  return(FALSE);
+}
+
+
+/**
+ * Batch function of the SDK. Copies the events into the ring and wakes up all waiting readers
+ * with a single futex call. The costs do not depend on the number of readers.
+ *
+ * @param events    The events of this main loop iteration
+ * @param count     Number of events
+ * @param user_data The writable mapping of the ring
+ */
+static void publish_batch (const nuimo_event *events, unsigned int count, void *user_data) {
+  struct nuimo_ring_s      *ring = user_data;
+  struct nuimo_ring_slot_s *slot;
+  guint64                   head;
+  unsigned int              i;
+
+  DEBUG_PRINT(("publish_batch\n"));
+
+  head = ring->head;
+
+  for (i = 0; i < count; i++) {
+    slot = &ring->slot[head & (NUIMO_RING_SLOTS - 1)];
+
+    // Mark the slot as invalid while writing; readers detect the overwrite by the sequence
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&slot->event, &events[i], sizeof(nuimo_event));
+    __atomic_store_n(&slot->seq, head + 1, __ATOMIC_RELEASE);
+
+    head++;
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+  }
+
+  __atomic_add_fetch(&ring->wakeup, 1, __ATOMIC_RELEASE);
+  syscall(SYS_futex, &ring->wakeup, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+
+/**
+ * Executes one command line received from a client. Known commands:
+ * \n \n
+ * LED  <22 hex digits bitmap> <brightness> <timeout> <mode> \n
+ * ICON <icon> <brightness> <timeout> <mode> \n
+ * READ <characteristic> \n
+ * \n
+ * The values of LED and ICON must be 0...255, READ accepts the readable characteristics only (not
+ * NUIMO_LED). The calls to the Nuimo are asynchronous; ::cb_command_done answers the client. READ is answered
+ * with the value as hex digits after the "OK".
+ *
+ * @param line   The command without line end
+ * @param client The client to answer
+ * @return Returns EXIT_SUCCESS if the command was issued; the answer follows from ::cb_command_done
+ */
+static int execute_command (char *line, client_s *client) {
+  char          hex[23];
+  unsigned char bitmap[11];
+  unsigned int  icon, brightness, timeout, mode, characteristic, i;
+
+  DEBUG_PRINT(("execute_command\n"));
+
+  // The values are bytes on the Nuimo; larger ones would be truncated silently
+  if (sscanf(line, "LED %22s %u %u %u", hex, &brightness, &timeout, &mode) == 4 && strlen(hex) == 22 &&
+      brightness <= 255 && timeout <= 255 && mode <= 255) {
+    for (i = 0; i < 11; i++) {
+      if (sscanf(&hex[i * 2], "%2hhx", &bitmap[i]) != 1) {
+	return(EXIT_FAILURE);
+      }
+    }
+    return(nuimo_set_led_async(bitmap, brightness, timeout, mode, cb_command_done, client));
+  }
+
+  if (sscanf(line, "ICON %u %u %u %u", &icon, &brightness, &timeout, &mode) == 4 &&
+      icon <= 255 && brightness <= 255 && timeout <= 255 && mode <= 255) {
+    return(nuimo_set_icon_async(icon, brightness, timeout, mode, cb_command_done, client));
+  }
+
+  // The LED matrix is write-only
+  if (sscanf(line, "READ %u", &characteristic) == 1 && characteristic > NUIMO && characteristic < NUIMO_ENTRIES_LEN &&
+      characteristic != NUIMO_LED) {
+    return(nuimo_read_value_async(characteristic, cb_command_done, client));
+  }
+
+  return(EXIT_FAILURE);
+}
+
+
+/**
+ * Answers a command once the Nuimo completed it and continues with the next buffered command
+ *
+ * @param result    EXIT_SUCCESS or EXIT_FAILURE
+ * @param data      The value read by READ; NULL otherwise
+ * @param len       Number of bytes in data
+ * @param user_data The ::client_s which sent the command
+ */
+static void cb_command_done (int result, const unsigned char *data, unsigned int len, void *user_data) {
+  client_s    *client = user_data;
+  char        *text;
+  unsigned int i;
+
+  DEBUG_PRINT(("cb_command_done\n"));
+
+  if (result != EXIT_SUCCESS) {
+    reply(client, "ERR\n");
+  } else {
+    text = malloc(4 + 2 * len);
+    if (!text) {
+      reply(client, "ERR\n");
+    } else {
+      strcpy(text, len ? "OK " : "OK");
+      for (i = 0; i < len; i++) {
+	sprintf(&text[3 + 2 * i], "%02x", data[i]);
+      }
+      strcat(text, "\n");
+      reply(client, text);
+      free(text);
+    }
+  }
+
+  // Watch the socket again once all buffered commands are answered
+  if (!next_command(client)) {
+    g_unix_fd_add(client->fd, G_IO_IN | G_IO_HUP | G_IO_ERR, cb_client, client);
+  }
+}
+
+
+/**
+ * Writes an answer to a client. A client which closed the socket meanwhile must not raise SIGPIPE.
+ *
+ * @param client The client
+ * @param text   The answer including the line end
+ */
+static void reply (client_s *client, const char *text) {
+  if (send(client->fd, text, strlen(text), MSG_NOSIGNAL) < 0) {
+    fprintf(stderr, "*EE* Error writing to client\n");
+  }
+}
+
+
+/**
+ * Executes the complete lines in the buffer of a client until one of them waits for the Nuimo.
+ * Commands which could not be issued are answered by "ERR" right away.
+ *
+ * @param client The client
+ * @return TRUE if a command is waiting for the Nuimo
+ */
+static gboolean next_command (client_s *client) {
+  char *end;
+  int   result;
+
+  DEBUG_PRINT(("next_command\n"));
+
+  while ((end = memchr(client->buf, '\n', client->len))) {
+    *end = '\0';
+    result = execute_command(client->buf, client);
+
+    client->len -= end + 1 - client->buf;
+    memmove(client->buf, end + 1, client->len);
+
+    if (result == EXIT_SUCCESS) {
+      return(TRUE);
+    }
+    reply(client, "ERR\n");
+  }
+
+  // Line too long; drop it
+  if (client->len == CMD_LEN) {
+    client->len = 0;
+  }
+
+  return(FALSE);
+}
+
+
+/**
+ * Receives commands from a client. Each complete line is executed and answered by "OK" or "ERR".
+ *
+ * @param fd        The socket of the client
+ * @param condition Not used
+ * @param user_data The ::client_s of this client
+ * @return FALSE if the client closed the connection or a command waits for the Nuimo
+ */
+static gboolean cb_client (gint fd, GIOCondition condition, gpointer user_data) {
+  client_s *client = user_data;
+  ssize_t   received;
+
+  DEBUG_PRINT(("cb_client\n"));
+
+  received = read(fd, &client->buf[client->len], CMD_LEN - client->len);
+  if (received <= 0) {
+    close(fd);
+    free(client);
+    return(FALSE);
+  }
+  client->len += received;
+
+  // The socket is watched again by cb_command_done
+  return(!next_command(client));
+}
+
+
+/**
+ * Accepts a new command client
+ *
+ * @param fd        The listening socket
+ * @param condition Not used
+ * @param user_data Not used
+ * @return Always TRUE to keep listening
+ */
+static gboolean cb_accept (gint fd, GIOCondition condition, gpointer user_data) {
+  client_s *client;
+  int       client_fd;
+
+  DEBUG_PRINT(("cb_accept\n"));
+
+  client_fd = accept(fd, NULL, NULL);
+  if (client_fd < 0) {
+    return(TRUE);
+  }
+
+  client = malloc(sizeof(client_s));
+  if (!client) {
+    close(client_fd);
+    return(TRUE);
+  }
+
+  client->fd  = client_fd;
+  client->len = 0;
+  g_unix_fd_add(client_fd, G_IO_IN | G_IO_HUP | G_IO_ERR, cb_client, client);
+
+  return(TRUE);
+}
+
+
+/**
+ * The fan-out daemon owns the Nuimo and publishes all events into the shared memory ring
+ * ::NUIMO_RING_NAME. LED and read commands are accepted on the Unix socket ::NUIMO_RING_SOCKET.
+ *
+ * @param argc Number of parameters
+ * @param argv Optional: Address of the Nuimo to connect to
+ */
+int main (int argc, char **argv) {
+  GMainLoop           *loop;
+  struct nuimo_ring_s *ring;
+  struct sockaddr_un   addr;
+  int                  shm_fd;
+  int                  sock_fd;
+  int                  result;
+  guint32              generation;
+
+  if (nuimo_init_status() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* Error initializing the SDK\n");
+    return(EXIT_FAILURE);
+  }
+  if (argc > 1 && nuimo_init_search("Address", argv[1]) != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* Error setting the address %s\n", argv[1]);
+    return(EXIT_FAILURE);
+  }
+
+  // Create the ring; readers map it read-only
+  shm_fd = shm_open(NUIMO_RING_NAME, O_CREAT | O_RDWR, 0644);
+  if (shm_fd < 0 || ftruncate(shm_fd, sizeof(struct nuimo_ring_s)) < 0) {
+    fprintf(stderr, "*EE* Error creating %s\n", NUIMO_RING_NAME);
+    return(EXIT_FAILURE);
+  }
+
+  ring = mmap(NULL, sizeof(struct nuimo_ring_s), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  close(shm_fd);
+  if (ring == MAP_FAILED) {
+    fprintf(stderr, "*EE* Error mapping %s\n", NUIMO_RING_NAME);
+    return(EXIT_FAILURE);
+  }
+
+  // Readers still attached from an earlier daemon see the new generation and move to the new head
+  generation = ring->magic == NUIMO_RING_MAGIC ? ring->generation + 1 : 1;
+  memset(ring, 0, sizeof(struct nuimo_ring_s));
+  ring->slots = NUIMO_RING_SLOTS;
+  __atomic_store_n(&ring->generation, generation, __ATOMIC_RELEASE);
+  __atomic_store_n(&ring->magic, NUIMO_RING_MAGIC, __ATOMIC_RELEASE);
+
+  // Command socket
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, NUIMO_RING_SOCKET, sizeof(addr.sun_path) - 1);
+  unlink(NUIMO_RING_SOCKET);
+
+  sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock_fd < 0 || bind(sock_fd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(sock_fd, 8) < 0) {
+    fprintf(stderr, "*EE* Error creating socket %s\n", NUIMO_RING_SOCKET);
+    return(EXIT_FAILURE);
+  }
+
+  nuimo_init_batch_function(publish_batch, ring);
+  result = nuimo_init_bt();
+
+  if (result == EXIT_SUCCESS) {
+    loop = g_main_loop_new(NULL, FALSE);
+    g_unix_fd_add(sock_fd, G_IO_IN, cb_accept, NULL);
+    g_unix_signal_add(SIGINT,  cb_termination, loop);
+    g_unix_signal_add(SIGTERM, cb_termination, loop);
+    g_main_loop_run(loop);
+  } else {
+    fprintf(stderr, "*EE* Error initializing the BT stack\n");
+  }
+
+  nuimo_disconnect();
+
+  close(sock_fd);
+  unlink(NUIMO_RING_SOCKET);
+  munmap(ring, sizeof(struct nuimo_ring_s));
+  shm_unlink(NUIMO_RING_NAME);
+
+  return(result);
+}
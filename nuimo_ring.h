@@ -0,0 +1,228 @@
+#ifndef _NUIMO_RING_H
+#define _NUIMO_RING_H
+
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "nuimo.h"
+
+
+/**
+ * @defgroup NUIMO_RING Shared memory event ring
+ * The nuimo_fanoutd daemon owns the Nuimo and publishes every event into a memory mapped ring.
+ * Any number of local processes can map the ring read-only. Each reader keeps its own cursor,
+ * so the daemon does not know (and does not care) how many readers exist. The daemon bumps the
+ * generation of the ring on each start; a reader still attached from an earlier daemon is moved
+ * to the new head. A typical reader:
+ *
+ * \code
+ * const struct nuimo_ring_s *ring = nuimo_ring_open(NUIMO_RING_NAME);
+ * struct nuimo_ring_cursor_s cursor;
+ * guint32     wakeup;
+ * nuimo_event event;
+ *
+ * nuimo_ring_attach(ring, &cursor);
+ * while (1) {
+ *   wakeup = nuimo_ring_wakeup(ring);
+ *   while (nuimo_ring_read(ring, &cursor, &event)) {
+ *     ...                                      // -1 means events got lost, cursor is moved on
+ *   }
+ *   nuimo_ring_wait(ring, wakeup, 1000);
+ * }
+ * \endcode
+ * @{
+ */
+#define NUIMO_RING_NAME    "/nuimo-events"           /// Name of the shared memory object (see shm_open)
+#define NUIMO_RING_SOCKET  "/tmp/nuimo-fanoutd.sock" /// Unix socket accepting LED and read commands
+#define NUIMO_RING_MAGIC   0x4e75696d                /// "Nuim"
+#define NUIMO_RING_SLOTS   1024                      /// Number of events in the ring; must be a power of 2
+/** @} */
+
+
+/**
+ * One slot of the ring. The sequence is set to 0 while the daemon writes the event and
+ * to the event index + 1 once the event is complete.
+ */
+struct nuimo_ring_slot_s {
+  guint64     seq;    /// Index + 1 of the event stored in this slot
+  nuimo_event event;  /// The event itself
+};
+
+/**
+ * Layout of the shared memory object
+ */
+struct nuimo_ring_s {
+  guint32                  magic;                    /// Always ::NUIMO_RING_MAGIC
+  guint32                  slots;                    /// Number of slots (::NUIMO_RING_SLOTS)
+  guint32                  wakeup;                   /// Futex; incremented after each published batch
+  guint32                  generation;               /// Incremented on each start of the daemon
+  guint64                  head;                     /// Number of events published so far
+  struct nuimo_ring_slot_s slot[NUIMO_RING_SLOTS];   /// The events
+};
+
+
+/**
+ * Private read position of a reader. A cursor set to 0 gets attached to the head on the first read.
+ */
+struct nuimo_ring_cursor_s {
+  guint64 position;    /// Index of the next event to read
+  guint32 generation;  /// Generation of the ring the position belongs to
+};
+
+
+/**
+ * Maps the ring read-only
+ *
+ * @param name Name of the shared memory object, usually ::NUIMO_RING_NAME
+ * @return Pointer to the ring or NULL in case of error
+ */
+static inline const struct nuimo_ring_s *nuimo_ring_open(const char *name) {
+  const struct nuimo_ring_s *ring;
+  int fd;
+
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return(NULL);
+  }
+
+  ring = mmap(NULL, sizeof(struct nuimo_ring_s), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (ring == MAP_FAILED) {
+    return(NULL);
+  }
+
+  if (ring->magic != NUIMO_RING_MAGIC || ring->slots != NUIMO_RING_SLOTS) {
+    munmap((void*) ring, sizeof(struct nuimo_ring_s));
+    return(NULL);
+  }
+
+  return(ring);
+}
+
+
+/**
+ * Unmaps the ring
+ *
+ * @param ring The ring returned by ::nuimo_ring_open
+ */
+static inline void nuimo_ring_close(const struct nuimo_ring_s *ring) {
+  munmap((void*) ring, sizeof(struct nuimo_ring_s));
+}
+
+
+/**
+ * Returns the current head. Use it as start value of the cursor to receive new events only.
+ *
+ * @param ring The ring returned by ::nuimo_ring_open
+ */
+static inline guint64 nuimo_ring_head(const struct nuimo_ring_s *ring) {
+  return(__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE));
+}
+
+
+/**
+ * Sets the cursor to the current head, so the reader receives new events only
+ *
+ * @param ring   The ring returned by ::nuimo_ring_open
+ * @param cursor The private cursor of the reader
+ */
+static inline void nuimo_ring_attach(const struct nuimo_ring_s *ring, struct nuimo_ring_cursor_s *cursor) {
+  cursor->generation = __atomic_load_n(&ring->generation, __ATOMIC_ACQUIRE);
+  cursor->position   = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * Returns the index of the oldest event still available
+ *
+ * @param head The head of the ring
+ */
+static inline guint64 nuimo_ring_oldest(guint64 head) {
+  return(head < NUIMO_RING_SLOTS ? 0 : head - NUIMO_RING_SLOTS);
+}
+
+
+/**
+ * Returns the wakeup counter. Read it before draining the ring and hand it over to ::nuimo_ring_wait
+ *
+ * @param ring The ring returned by ::nuimo_ring_open
+ */
+static inline guint32 nuimo_ring_wakeup(const struct nuimo_ring_s *ring) {
+  return(__atomic_load_n(&ring->wakeup, __ATOMIC_ACQUIRE));
+}
+
+
+/**
+ * Reads the event at the cursor and moves the cursor on
+ *
+ * @param ring   The ring returned by ::nuimo_ring_open
+ * @param cursor The private cursor of the reader
+ * @param event  Receives the event
+ * @return 1 if an event was read, 0 if there is no new event and -1 if the reader was too slow
+ *         and events got overwritten (the cursor is moved to the oldest available event) or the
+ *         daemon was restarted (the cursor is moved to the head)
+ */
+static inline int nuimo_ring_read(const struct nuimo_ring_s *ring, struct nuimo_ring_cursor_s *cursor, nuimo_event *event) {
+  const struct nuimo_ring_slot_s *slot;
+  guint64 head;
+  guint32 generation;
+
+  generation = __atomic_load_n(&ring->generation, __ATOMIC_ACQUIRE);
+  head       = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+  // The positions of an earlier daemon are meaningless in the new ring
+  if (generation != cursor->generation) {
+    cursor->generation = generation;
+    cursor->position   = head;
+    return(-1);
+  }
+
+  if (cursor->position >= head) {
+    return(0);
+  }
+
+  if (head - cursor->position > NUIMO_RING_SLOTS) {
+    cursor->position = nuimo_ring_oldest(head);
+    return(-1);
+  }
+
+  slot = &ring->slot[cursor->position & (NUIMO_RING_SLOTS - 1)];
+  memcpy(event, &slot->event, sizeof(nuimo_event));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  // The daemon overwrote the slot while copying
+  if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != cursor->position + 1) {
+    cursor->position = nuimo_ring_oldest(__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE));
+    return(-1);
+  }
+
+  cursor->position++;
+  return(1);
+}
+
+
+/**
+ * Sleeps until the daemon publishes new events (or the timeout is over)
+ *
+ * @param ring    The ring returned by ::nuimo_ring_open
+ * @param wakeup  The value returned by ::nuimo_ring_wakeup before draining the ring
+ * @param timeout Timeout in milliseconds
+ */
+static inline void nuimo_ring_wait(const struct nuimo_ring_s *ring, guint32 wakeup, unsigned int timeout) {
+  struct timespec ts;
+
+  ts.tv_sec  = timeout / 1000;
+  ts.tv_nsec = (timeout % 1000) * 1000000L;
+
+  syscall(SYS_futex, &ring->wakeup, FUTEX_WAIT, wakeup, &ts, NULL, 0);
+}
+
+
+#endif
@@ -0,0 +1,590 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <gio/gio.h>
+#include <glib-unix.h>
+
+/**
+ * Stand-in for BlueZ on a private bus. It exports just enough of the BlueZ API (ObjectManager,
+ * Adapter1, Device1, GattCharacteristic1) to drive the SDK through connect, notify and
+ * disconnect without any Bluetooth hardware. Start it on a private bus with test/run_standin.sh.
+ * \n \n
+ * Usage: bluez_standin <adapter>... [--nuimo <adapter>]... [--busy <adapter>]... [--late]
+ *                      [--fail-connect <n>] [--fail-notify <n>] [--noise <n>] [--input <n>]
+ *                      [--rotation <n>] [--stall <method>]...
+ *
+ * Each --nuimo adds a Nuimo reported by the given adapter. The GATT characteristics of a Nuimo
+ * appear once it got connected, like with BlueZ. Each --busy adds another connected device to the
+ * given adapter. With --late the Nuimos are reported only once their adapter started the discovery.
+ * --fail-connect lets the first n Connect calls fail, --fail-notify the first n StartNotify calls.
+ * --noise adds a device nearby which changes its RSSI n times per second, like during a discovery.
+ * --input lets each connected Nuimo send n gestures per second: button press, rotation left,
+ * button release and rotation right, all at once. So the left rotations happen with the button
+ * held and the right ones without. --rotation lets each connected Nuimo send n rotations per second.
+ * Each --stall lets the calls of the given method (e.g. Disconnect) never be answered.
+ */
+
+#define STANDIN_ADDRESS "DB:3B:2B:00:00:01"  /// Address of all stand-in Nuimos
+#define STANDIN_BUTTON   2                   /// Index of the button characteristic in STANDIN_UUID
+#define STANDIN_ROTATION 5                   /// Index of the rotation characteristic in STANDIN_UUID
+
+/**
+ * Kind of an exported object
+ */
+enum standin_kind {
+  STANDIN_ADAPTER = 0,
+  STANDIN_DEVICE,
+  STANDIN_CHARACTERISTIC
+};
+
+/**
+ * One exported object with exactly one BlueZ interface
+ */
+typedef struct {
+  unsigned int kind;        /// Based on ::standin_kind
+  gchar       *path;        /// D-Bus path
+  const gchar *interface;   /// The BlueZ interface
+  GHashTable  *properties;  /// Property name -> GVariant
+  guint        id;          /// Registration id of the object
+}object_s;
+
+
+/**
+ * UUIDs of the characteristics exported for each Nuimo (see NUIMO_UUID in nuimo.c)
+ */
+static const char *STANDIN_UUID[] = {
+  "00002a19-0000-1000-8000-00805f9b34fb",
+  "f29b1524-cb19-40f3-be5c-7241ecb82fd1",
+  "f29b1529-cb19-40f3-be5c-7241ecb82fd2",
+  "f29b1526-cb19-40f3-be5c-7241ecb82fd2",
+  "f29b1527-cb19-40f3-be5c-7241ecb82fd2",
+  "f29b1528-cb19-40f3-be5c-7241ecb82fd2",
+  NULL
+};
+
+
+static const gchar STANDIN_XML[] =
+  "<node>"
+  " <interface name='org.freedesktop.DBus.ObjectManager'>"
+  "  <method name='GetManagedObjects'><arg type='a{oa{sa{sv}}}' direction='out'/></method>"
+  " </interface>"
+  " <interface name='org.bluez.Adapter1'>"
+  "  <method name='StartDiscovery'/>"
+  "  <method name='StopDiscovery'/>"
+  "  <property name='Address' type='s' access='read'/>"
+  "  <property name='Powered' type='b' access='read'/>"
+  "  <property name='Discovering' type='b' access='read'/>"
+  " </interface>"
+  " <interface name='org.bluez.Device1'>"
+  "  <method name='Connect'/>"
+  "  <method name='Disconnect'/>"
+  "  <property name='Address' type='s' access='read'/>"
+  "  <property name='Name' type='s' access='read'/>"
+  "  <property name='Adapter' type='o' access='read'/>"
+  "  <property name='Connected' type='b' access='read'/>"
+  "  <property name='RSSI' type='n' access='read'/>"
+  " </interface>"
+  " <interface name='org.bluez.GattCharacteristic1'>"
+  "  <method name='StartNotify'/>"
+  "  <method name='StopNotify'/>"
+  "  <method name='ReadValue'><arg type='a{sv}' direction='in'/><arg type='ay' direction='out'/></method>"
+  "  <method name='WriteValue'><arg type='ay' direction='in'/><arg type='a{sv}' direction='in'/></method>"
+  "  <property name='UUID' type='s' access='read'/>"
+  "  <property name='Notifying' type='b' access='read'/>"
+  "  <property name='Value' type='ay' access='read'/>"
+  " </interface>"
+  "</node>";
+
+
+// prototypes for private functions
+static object_s *add_object (unsigned int kind, const gchar *path, const gchar *interface);
+static void      announce_object (object_s *object);
+static object_s *find_object (const gchar *path);
+static void      set_property (object_s *object, const gchar *name, GVariant *value);
+static GVariant *object_interfaces (object_s *object);
+static void      add_characteristics (object_s *device);
+static object_s *add_device (const gchar *adapter, const gchar *address, const gchar *name, gboolean connected);
+static void      add_nuimos (const gchar *adapter);
+static gboolean  cb_noise (gpointer user_data);
+static void      notify_value (const char *uuid, const guchar *value, gsize len);
+static gboolean  cb_input (gpointer user_data);
+static gboolean  cb_rotation (gpointer user_data);
+static void      cb_method_call (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *method, GVariant *parameters, GDBusMethodInvocation *invocation, gpointer user_data);
+static GVariant *cb_get_property (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *property, GError **error, gpointer user_data);
+static void      cb_bus_acquired (GDBusConnection *connection, const gchar *name, gpointer user_data);
+static void      cb_name_lost (GDBusConnection *connection, const gchar *name, gpointer user_data);
+static gboolean  cb_termination (gpointer data);
+
+
+static GDBusConnection *bus;             /// The (stand-in) system bus
+static GDBusNodeInfo   *info;            /// Introspection data of all interfaces
+static GPtrArray       *objects;         /// All exported objects
+static char           **adapters;        /// Names of the adapters from the command line
+static char           **nuimos;          /// Adapters reporting a Nuimo
+static char           **busy;            /// Adapters with another connected device
+static char           **stall;           /// Methods never answered
+static GPtrArray       *stalled;         /// The calls never answered
+static gboolean         late;            /// TRUE to report the Nuimos only by the discovery
+static object_s        *noisy;           /// Device nearby changing its RSSI; NULL if none
+static int              failures;        /// Number of Connect calls still to fail
+static int              notify_failures; /// Number of StartNotify calls still to fail
+static int              noise;           /// RSSI changes per second of the device nearby
+static int              input;           /// Gestures per second of the connected Nuimos
+static int              rotation;        /// Rotations per second of the connected Nuimos
+
+static const GDBusInterfaceVTable vtable = {cb_method_call, cb_get_property, NULL, {NULL}};
+
+
+/**
+ * Exports a new object and announces it with InterfacesAdded
+ *
+ * @param kind      Based on ::standin_kind
+ * @param path      D-Bus path
+ * @param interface The BlueZ interface
+ * @return The new object
+ */
+static object_s *add_object (unsigned int kind, const gchar *path, const gchar *interface) {
+  object_s *object;
+  GError   *error = NULL;
+
+  object             = g_new0(object_s, 1);
+  object->kind       = kind;
+  object->path       = g_strdup(path);
+  object->interface  = interface;
+  object->properties = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+
+  object->id = g_dbus_connection_register_object(bus, path, g_dbus_node_info_lookup_interface(info, interface),
+						 &vtable, object, NULL, &error);
+  if (!object->id) {
+    fprintf(stderr, "*EE* Error registering %s: %s\n", path, error->message);
+    g_error_free(error);
+  }
+  g_ptr_array_add(objects, object);
+
+  return(object);
+}
+
+
+/**
+ * Announces the properties of a new object. Call after all properties are set.
+ *
+ * @param object The object
+ */
+static void announce_object (object_s *object) {
+  g_dbus_connection_emit_signal(bus, NULL, "/", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
+				g_variant_new("(o@a{sa{sv}})", object->path, object_interfaces(object)), NULL);
+}
+
+
+/**
+ * Looks up an object by its path
+ *
+ * @param path D-Bus path
+ * @return The object or NULL
+ */
+static object_s *find_object (const gchar *path) {
+  unsigned int i;
+
+  for (i = 0; i < objects->len; i++) {
+    if (!strcmp(((object_s*) g_ptr_array_index(objects, i))->path, path)) {
+      return(g_ptr_array_index(objects, i));
+    }
+  }
+
+  return(NULL);
+}
+
+
+/**
+ * Sets a property and emits PropertiesChanged if the object is announced
+ *
+ * @param object The object
+ * @param name   Name of the property
+ * @param value  The new (floating) value
+ */
+static void set_property (object_s *object, const gchar *name, GVariant *value) {
+  GVariantBuilder changed;
+
+  g_variant_ref_sink(value);
+  g_hash_table_insert(object->properties, g_strdup(name), value);
+
+  g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+  g_variant_builder_add(&changed, "{sv}", name, value);
+  g_dbus_connection_emit_signal(bus, NULL, object->path, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+				g_variant_new("(sa{sv}as)", object->interface, &changed, NULL), NULL);
+}
+
+
+/**
+ * Builds the a{sa{sv}} dictionary of an object as used by GetManagedObjects and InterfacesAdded
+ *
+ * @param object The object
+ * @return The floating dictionary
+ */
+static GVariant *object_interfaces (object_s *object) {
+  GVariantBuilder interfaces;
+  GVariantBuilder properties;
+  GHashTableIter  iter;
+  gpointer        name, value;
+
+  g_variant_builder_init(&properties, G_VARIANT_TYPE("a{sv}"));
+  g_hash_table_iter_init(&iter, object->properties);
+  while (g_hash_table_iter_next(&iter, &name, &value)) {
+    g_variant_builder_add(&properties, "{sv}", name, value);
+  }
+
+  g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+  g_variant_builder_add(&interfaces, "{sa{sv}}", object->interface, &properties);
+
+  return(g_variant_builder_end(&interfaces));
+}
+
+
+/**
+ * Adds the GATT characteristics of a connected Nuimo
+ *
+ * @param device The device object of the Nuimo
+ */
+static void add_characteristics (object_s *device) {
+  object_s    *object;
+  gchar       *path;
+  unsigned int i;
+
+  for (i = 0; STANDIN_UUID[i]; i++) {
+    path = g_strdup_printf("%s/service000c/char%04x", device->path, 0x0d + 3 * i);
+    if (!find_object(path)) {
+      object = add_object(STANDIN_CHARACTERISTIC, path, "org.bluez.GattCharacteristic1");
+      g_hash_table_insert(object->properties, g_strdup("UUID"), g_variant_ref_sink(g_variant_new_string(STANDIN_UUID[i])));
+      g_hash_table_insert(object->properties, g_strdup("Notifying"), g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+      announce_object(object);
+    }
+    g_free(path);
+  }
+}
+
+
+/**
+ * Adds a device to an adapter
+ *
+ * @param adapter   Path of the adapter
+ * @param address   Address of the device
+ * @param name      Name of the device
+ * @param connected Initial state of the Connected property
+ * @return The new object
+ */
+static object_s *add_device (const gchar *adapter, const gchar *address, const gchar *name, gboolean connected) {
+  object_s *object;
+  gchar    *path;
+
+  path   = g_strdelimit(g_strdup_printf("%s/dev_%s", adapter, address), ":", '_');
+  object = add_object(STANDIN_DEVICE, path, "org.bluez.Device1");
+  g_hash_table_insert(object->properties, g_strdup("Address"), g_variant_ref_sink(g_variant_new_string(address)));
+  g_hash_table_insert(object->properties, g_strdup("Name"), g_variant_ref_sink(g_variant_new_string(name)));
+  g_hash_table_insert(object->properties, g_strdup("Adapter"), g_variant_ref_sink(g_variant_new_object_path(adapter)));
+  g_hash_table_insert(object->properties, g_strdup("Connected"), g_variant_ref_sink(g_variant_new_boolean(connected)));
+  g_free(path);
+
+  return(object);
+}
+
+
+/**
+ * Adds the Nuimos reported by an adapter unless they exist already. Nuimos added after
+ * the start are announced with InterfacesAdded.
+ *
+ * @param adapter Path of the adapter; NULL for all adapters at the start
+ */
+static void add_nuimos (const gchar *adapter) {
+  gchar       *path;
+  gchar       *device;
+  unsigned int i;
+
+  for (i = 0; nuimos[i]; i++) {
+    path   = g_strdup_printf("/org/bluez/%s", nuimos[i]);
+    device = g_strdelimit(g_strdup_printf("%s/dev_%s", path, STANDIN_ADDRESS), ":", '_');
+    if (!adapter) {
+      add_device(path, STANDIN_ADDRESS, "Nuimo", FALSE);
+    } else if (!strcmp(adapter, path) && !find_object(device)) {
+      announce_object(add_device(path, STANDIN_ADDRESS, "Nuimo", FALSE));
+    }
+    g_free(device);
+    g_free(path);
+  }
+}
+
+
+/**
+ * Changes the RSSI of the device nearby
+ *
+ * @param user_data Not used
+ * @return TRUE to keep the timer
+ */
+static gboolean cb_noise (gpointer user_data) {
+  set_property(noisy, "RSSI", g_variant_new_int16(-40 - g_random_int_range(0, 40)));
+
+  return(TRUE);
+}
+
+
+/**
+ * Sends a new value of a characteristic of all Nuimos having the notifications armed
+ *
+ * @param uuid  UUID of the characteristic
+ * @param value The value
+ * @param len   Length of the value
+ */
+static void notify_value (const char *uuid, const guchar *value, gsize len) {
+  object_s    *object;
+  GVariant    *v;
+  unsigned int i;
+
+  for (i = 0; i < objects->len; i++) {
+    object = g_ptr_array_index(objects, i);
+    if (object->kind != STANDIN_CHARACTERISTIC || strcmp(g_variant_get_string(g_hash_table_lookup(object->properties, "UUID"), NULL), uuid)) {
+      continue;
+    }
+    v = g_hash_table_lookup(object->properties, "Notifying");
+    if (v && g_variant_get_boolean(v)) {
+      set_property(object, "Value", g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, value, len, 1));
+    }
+  }
+}
+
+
+/**
+ * Sends one gesture (see --input)
+ *
+ * @param user_data Not used
+ * @return TRUE to keep the timer
+ */
+static gboolean cb_input (gpointer user_data) {
+  static const guchar press[]   = {1};
+  static const guchar release[] = {0};
+  static const guchar left[]    = {10, 0};
+  static const guchar right[]   = {0xf6, 0xff};
+
+  notify_value(STANDIN_UUID[STANDIN_BUTTON], press, sizeof(press));
+  notify_value(STANDIN_UUID[STANDIN_ROTATION], left, sizeof(left));
+  notify_value(STANDIN_UUID[STANDIN_BUTTON], release, sizeof(release));
+  notify_value(STANDIN_UUID[STANDIN_ROTATION], right, sizeof(right));
+
+  return(TRUE);
+}
+
+
+/**
+ * Sends one rotation (see --rotation)
+ *
+ * @param user_data Not used
+ * @return TRUE to keep the timer
+ */
+static gboolean cb_rotation (gpointer user_data) {
+  static const guchar left[] = {1, 0};
+
+  notify_value(STANDIN_UUID[STANDIN_ROTATION], left, sizeof(left));
+
+  return(TRUE);
+}
+
+
+/**
+ * Implements the methods of all interfaces
+ */
+static void cb_method_call (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *method, GVariant *parameters, GDBusMethodInvocation *invocation, gpointer user_data) {
+  object_s        *object = user_data;
+  GVariantBuilder  all;
+  unsigned int     i;
+  static const guchar battery[] = {100};
+
+  // Keep the call, so GDBus does not complain about a call without reply
+  if (g_strv_contains((const gchar * const *) stall, method)) {
+    g_ptr_array_add(stalled, g_object_ref(invocation));
+    return;
+  }
+
+  if (!strcmp(method, "GetManagedObjects")) {
+    g_variant_builder_init(&all, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+    for (i = 0; i < objects->len; i++) {
+      object = g_ptr_array_index(objects, i);
+      g_variant_builder_add(&all, "{o@a{sa{sv}}}", object->path, object_interfaces(object));
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{oa{sa{sv}}})", &all));
+    return;
+  }
+
+  if (!strcmp(method, "StartDiscovery") || !strcmp(method, "StopDiscovery")) {
+    set_property(object, "Discovering", g_variant_new_boolean(!strcmp(method, "StartDiscovery")));
+    if (late && !strcmp(method, "StartDiscovery")) {
+      add_nuimos(object->path);
+    }
+  } else if (!strcmp(method, "Connect") && failures > 0) {
+    failures--;
+    g_dbus_method_invocation_return_error_literal(invocation, G_IO_ERROR, G_IO_ERROR_FAILED, "Connection refused");
+    return;
+  } else if (!strcmp(method, "Connect")) {
+    set_property(object, "Connected", g_variant_new_boolean(TRUE));
+    add_characteristics(object);
+  } else if (!strcmp(method, "StartNotify") && notify_failures > 0) {
+    notify_failures--;
+    g_dbus_method_invocation_return_error_literal(invocation, G_IO_ERROR, G_IO_ERROR_FAILED, "Not permitted");
+    return;
+  } else if (!strcmp(method, "Disconnect")) {
+    set_property(object, "Connected", g_variant_new_boolean(FALSE));
+  } else if (!strcmp(method, "StartNotify") || !strcmp(method, "StopNotify")) {
+    set_property(object, "Notifying", g_variant_new_boolean(!strcmp(method, "StartNotify")));
+  } else if (!strcmp(method, "ReadValue")) {
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(@ay)", g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, battery, 1, 1)));
+    return;
+  }
+
+  g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+
+/**
+ * Implements the Get/GetAll of all interfaces
+ */
+static GVariant *cb_get_property (GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *property, GError **error, gpointer user_data) {
+  object_s *object = user_data;
+  GVariant *value;
+
+  value = g_hash_table_lookup(object->properties, property);
+  if (!value) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No property %s", property);
+    return(NULL);
+  }
+
+  return(g_variant_ref(value));
+}
+
+
+/**
+ * Exports the ObjectManager, the adapters and the Nuimos as soon as the bus is available
+ */
+static void cb_bus_acquired (GDBusConnection *connection, const gchar *name, gpointer user_data) {
+  object_s    *object;
+  gchar       *path;
+  gchar       *adapter;
+  gchar       *address;
+  unsigned int i;
+
+  bus = connection;
+  g_dbus_connection_register_object(bus, "/", g_dbus_node_info_lookup_interface(info, "org.freedesktop.DBus.ObjectManager"),
+				    &vtable, NULL, NULL, NULL);
+
+  for (i = 0; adapters[i]; i++) {
+    path   = g_strdup_printf("/org/bluez/%s", adapters[i]);
+    object = add_object(STANDIN_ADAPTER, path, "org.bluez.Adapter1");
+    g_hash_table_insert(object->properties, g_strdup("Address"), g_variant_ref_sink(g_variant_new_string("00:00:00:00:00:00")));
+    g_hash_table_insert(object->properties, g_strdup("Powered"), g_variant_ref_sink(g_variant_new_boolean(TRUE)));
+    g_hash_table_insert(object->properties, g_strdup("Discovering"), g_variant_ref_sink(g_variant_new_boolean(FALSE)));
+    g_free(path);
+  }
+
+  if (!late) {
+    add_nuimos(NULL);
+  }
+
+  if (noise > 0 && adapters[0]) {
+    adapter = g_strdup_printf("/org/bluez/%s", adapters[0]);
+    noisy   = add_device(adapter, "00:00:00:00:01:00", "Other", FALSE);
+    g_timeout_add(MAX(1000 / noise, 1), cb_noise, NULL);
+    g_free(adapter);
+  }
+
+  if (input > 0) {
+    g_timeout_add(MAX(1000 / input, 1), cb_input, NULL);
+  }
+
+  if (rotation > 0) {
+    g_timeout_add(MAX(1000 / rotation, 1), cb_rotation, NULL);
+  }
+
+  for (i = 0; busy[i]; i++) {
+    adapter = g_strdup_printf("/org/bluez/%s", busy[i]);
+    address = g_strdup_printf("00:00:00:00:00:%02X", i + 1);
+    add_device(adapter, address, "Other", TRUE);
+    g_free(address);
+    g_free(adapter);
+  }
+}
+
+
+/**
+ * Quits if the name org.bluez can not be owned
+ */
+static void cb_name_lost (GDBusConnection *connection, const gchar *name, gpointer user_data) {
+  fprintf(stderr, "*EE* Could not own %s\n", name);
+  g_main_loop_quit(user_data);
+}
+
+
+/**
+ * Stops the g_main_loop
+ *
+ * @param data Is the g_main_loop handle
+ */
+static gboolean cb_termination (gpointer data) {
+  g_main_loop_quit(data);
+
+  return(FALSE);
+}
+
+
+int main (int argc, char **argv) {
+  GMainLoop   *loop;
+  GPtrArray   *adapter_list;
+  GPtrArray   *nuimo_list;
+  GPtrArray   *busy_list;
+  GPtrArray   *stall_list;
+  int          i;
+
+  adapter_list = g_ptr_array_new();
+  nuimo_list   = g_ptr_array_new();
+  busy_list    = g_ptr_array_new();
+  stall_list   = g_ptr_array_new();
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--nuimo") && i + 1 < argc) {
+      g_ptr_array_add(nuimo_list, argv[++i]);
+    } else if (!strcmp(argv[i], "--busy") && i + 1 < argc) {
+      g_ptr_array_add(busy_list, argv[++i]);
+    } else if (!strcmp(argv[i], "--noise") && i + 1 < argc) {
+      noise = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--input") && i + 1 < argc) {
+      input = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--stall") && i + 1 < argc) {
+      g_ptr_array_add(stall_list, argv[++i]);
+    } else if (!strcmp(argv[i], "--rotation") && i + 1 < argc) {
+      rotation = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--late")) {
+      late = TRUE;
+    } else if (!strcmp(argv[i], "--fail-connect") && i + 1 < argc) {
+      failures = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--fail-notify") && i + 1 < argc) {
+      notify_failures = atoi(argv[++i]);
+    } else {
+      g_ptr_array_add(adapter_list, argv[i]);
+    }
+  }
+  g_ptr_array_add(adapter_list, NULL);
+  g_ptr_array_add(nuimo_list, NULL);
+  g_ptr_array_add(busy_list, NULL);
+  g_ptr_array_add(stall_list, NULL);
+  adapters = (char**) g_ptr_array_free(adapter_list, FALSE);
+  nuimos   = (char**) g_ptr_array_free(nuimo_list, FALSE);
+  busy     = (char**) g_ptr_array_free(busy_list, FALSE);
+  stall    = (char**) g_ptr_array_free(stall_list, FALSE);
+
+  info    = g_dbus_node_info_new_for_xml(STANDIN_XML, NULL);
+  objects = g_ptr_array_new();
+  stalled = g_ptr_array_new();
+  loop    = g_main_loop_new(NULL, FALSE);
+
+  g_bus_own_name(G_BUS_TYPE_SYSTEM, "org.bluez", G_BUS_NAME_OWNER_FLAGS_NONE, cb_bus_acquired, NULL, cb_name_lost, loop, NULL);
+  g_unix_signal_add(SIGINT,  cb_termination, loop);
+  g_unix_signal_add(SIGTERM, cb_termination, loop);
+  g_main_loop_run(loop);
+
+  return(EXIT_SUCCESS);
+}
@@ -0,0 +1,760 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <gio/gio.h>
+
+#include "nuimo.h"
+
+/**
+ * Tests of the SDK running against test/bluez_standin (see test/run_standin.sh).
+ * \n \n
+ * soak <cycles> \n
+ * Connects and disconnects the Nuimo the given number of times. After a warm-up the bytes allocated
+ * by malloc must stay flat; otherwise the test fails. The resident set size is reported. Run it with
+ * GLIBC_TUNABLES=glibc.malloc.tcache_count=0 (see the soak target of the Makefile); the per-thread
+ * caches of malloc otherwise count as allocated and fill up over the first few thousand cycles.
+ * \n \n
+ * watchdog [off] \n
+ * Runs with the watchdog enabled against a stand-in started with --fail-notify 1. The failed
+ * StartNotify must lead to a reconnect, and the silence of the stand-in to probes and re-armed
+ * notifications. READY and the ready function must come exactly once for the connection. With
+ * off the watchdog stays disabled; the failed StartNotify must lead to a reconnect all the same.
+ * \n \n
+ * placement [direct] \n
+ * Runs against a stand-in with several adapters reporting the Nuimo only by the discovery
+ * (--late) and other devices connected to some of them (--busy). The Nuimo must be connected
+ * through the least loaded adapter. With direct the SDK runs in NUIMO_BUS_DIRECT mode.
+ * \n \n
+ * bench <seconds> [direct] \n
+ * Keeps the Nuimo connected for the given time against a stand-in started with --noise and
+ * reports the wakeups (D-Bus signals received) and the CPU time per second. With direct the
+ * SDK runs in NUIMO_BUS_DIRECT mode. This is a measurement; it only fails if the Nuimo does
+ * not get ready.
+ * \n \n
+ * bindings <seconds> \n
+ * Checks that invalid binding configs are rejected and measures the dispatch cost per event
+ * against a stand-in started with --input, first without bindings and then with every key of
+ * the binding table bound. The rotations to the left arrive with the button held and must call
+ * the held actions, the ones to the right the others.
+ * \n \n
+ * latency <seconds> \n
+ * Runs against a stand-in started with --input (button presses), --rotation and --noise while a
+ * slow batch function takes TEST_SLOW_BATCH per batch and other work of the application keeps the
+ * main loop busy at default priority. The rotations are merged while waiting and the button events
+ * must not wait longer than TEST_MAX_BUTTON_LATENCY.
+ * \n \n
+ * stall <method>... \n
+ * Runs against a stand-in never answering the given methods (--stall Disconnect and/or --stall
+ * StopNotify). nuimo_disconnect_deadline(TEST_STALL_DEADLINE) must return after the deadline, but
+ * not later than TEST_STALL_SLACK, and report exactly the steps of the stalled methods as not
+ * completed.
+ * \n \n
+ * persistent \n
+ * Keeps a frame on the display with nuimo_set_persistent. Writing the same frame again must be
+ * skipped, the frame must be refreshed once per period (TEST_PERIODS periods), after a widget
+ * frame lapsed and after a reconnect. Build with short refresh times (see the Makefile); the
+ * default period is 25.5 s.
+ */
+
+#define TEST_READY_TIMEOUT 5000     /// Max. time in ms a cycle may take to get ready
+#define TEST_WARMUP        20       /// Cycles before the first measurement (GLib fills its caches)
+#define TEST_MAX_GROWTH    (16 * 1024) /// Max. growth in bytes of the allocations after the warm-up
+#define TEST_SILENCE       1500     /// Silence in ms before the watchdog probes
+#define TEST_WATCHDOG_RUN  6000     /// Duration in ms of the watchdog test
+#define TEST_SLOW_BATCH    5000     /// Time in microseconds the slow batch function of the latency test takes
+#define TEST_MAX_BUTTON_LATENCY 50000 /// Max. time in microseconds from the arrival of a button event until its delivery
+#define TEST_STALL_DEADLINE 200     /// Deadline in ms of the teardown against a stalling stand-in
+#define TEST_STALL_SLACK    100     /// Max. time in ms the teardown may take beyond the deadline
+#define TEST_PERIODS        3       /// Refresh periods of the persistent test
+
+// Period in ms of the persistent frame; the SDK must be built with the same value
+#ifdef NUIMO_PERSISTENT_TIMEOUT
+#define TEST_PERIOD (NUIMO_PERSISTENT_TIMEOUT * 100)
+#else
+#define TEST_PERIOD 25500
+#endif
+
+/**
+ * All keys of the binding table (characteristic and direction)
+ */
+static const char *TEST_KEYS[] = {
+  "CONNECTION LOST", "CONNECTION READY", "BATTERY LEVEL", "BUTTON RELEASE", "BUTTON PRESS",
+  "FLY LEFT", "FLY RIGHT", "FLY UPDOWN", "SWIPE LEFT", "SWIPE RIGHT", "SWIPE UP", "SWIPE DOWN",
+  "SWIPE TOUCH_LEFT", "SWIPE TOUCH_RIGHT", "SWIPE TOUCH_TOP", "SWIPE TOUCH_BOTTOM",
+  "SWIPE LONG_TOUCH_LEFT", "SWIPE LONG_TOUCH_RIGHT", "SWIPE LONG_TOUCH_TOP", "SWIPE LONG_TOUCH_BOTTOM",
+  "ROTATION LEFT", "ROTATION RIGHT",
+  NULL
+};
+
+/**
+ * Binding configs which must be rejected
+ */
+static const char *TEST_INVALID[] = {
+  "BUTTON PRESS scene 1\nBUTTON PRESS scene 2",
+  "ROTATION * volume\nROTATION LEFT volume",
+  "ROTATION LEFT volume 1 held\nROTATION * brightness held",
+  "BUTTON PRESS scene 2147483648",
+  "BUTTON PRESS scene -2147483649",
+  "BUTTON PRESS scene 99999999999999999999",
+  "BUTTON PRESS scene 1 2",
+  "BUTTON PRESS scene 1x",
+  NULL
+};
+
+/**
+ * Counters of the dispatch
+ */
+typedef struct {
+  gint64       mark;      /// Time of the batch start or of the last event delivered
+  gint64       time;      /// Time in microseconds spent to deliver the events
+  unsigned int events;    /// Number of delivered events
+  unsigned int actions;   /// Number of called actions
+  unsigned int wrong;     /// Number of rotations calling the action of the wrong button state
+}dispatch_s;
+
+/**
+ * Memory counters of the process
+ */
+typedef struct {
+  long   rss;        /// Resident set size in bytes
+  size_t allocated;  /// Bytes allocated by malloc and not freed
+}memory_s;
+
+
+// prototypes for private functions
+static void     cb_ready (void *user_data);
+static void     cb_count (void *user_data);
+static void     cb_count_event (const nuimo_event *event, void *user_data);
+static gboolean cb_timeout (gpointer user_data);
+static int      run_until_ready ();
+static void     get_memory (memory_s *memory);
+static int      test_soak (unsigned int cycles);
+static int      test_watchdog (gboolean enabled);
+static int      test_placement (gboolean direct);
+static gint64   get_cpu_time ();
+static int      bench (unsigned int seconds, gboolean direct);
+static void     cb_batch (const nuimo_event *events, unsigned int count, void *user_data);
+static void     cb_event (unsigned int characteristic, int value, unsigned int direction, void *user_data);
+static void     cb_action (const char *action, int argument, const nuimo_event *event, void *user_data);
+static void     measure_dispatch (unsigned int seconds, dispatch_s *dispatch);
+static int      bench_bindings (unsigned int seconds);
+static void     cb_slow_batch (const nuimo_event *events, unsigned int count, void *user_data);
+static gboolean cb_busy (gpointer user_data);
+static int      test_latency (unsigned int seconds);
+static int      test_stall (char **methods);
+static void     run_for (unsigned int time);
+static int      test_persistent ();
+
+
+static GMainLoop *loop;     /// The main loop of the test
+static gboolean   expired;  /// TRUE once the ready timeout passed
+
+
+/**
+ * Ready function of the SDK; stops the main loop
+ *
+ * @param user_data Not used
+ */
+static void cb_ready (void *user_data) {
+  g_main_loop_quit(loop);
+}
+
+
+/**
+ * Ready function counting its calls
+ *
+ * @param user_data Pointer to the counter
+ */
+static void cb_count (void *user_data) {
+  (*(unsigned int*) user_data)++;
+}
+
+
+/**
+ * Handler counting its events
+ *
+ * @param event     Not used
+ * @param user_data Pointer to the counter
+ */
+static void cb_count_event (const nuimo_event *event, void *user_data) {
+  (*(unsigned int*) user_data)++;
+}
+
+
+/**
+ * Stops the main loop if the Nuimo did not get ready in time
+ *
+ * @param user_data Not used
+ * @return FALSE to remove the timer
+ */
+static gboolean cb_timeout (gpointer user_data) {
+  expired = TRUE;
+  g_main_loop_quit(loop);
+
+  return(FALSE);
+}
+
+
+/**
+ * Runs the main loop until the Nuimo is ready or TEST_READY_TIMEOUT passed
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE on timeout
+ */
+static int run_until_ready () {
+  guint timer;
+
+  expired = FALSE;
+  timer   = g_timeout_add(TEST_READY_TIMEOUT, cb_timeout, NULL);
+  g_main_loop_run(loop);
+  if (!expired) {
+    g_source_remove(timer);
+  }
+
+  return(expired ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+/**
+ * Reads the memory counters of the process
+ *
+ * @param memory Receives the counters
+ */
+static void get_memory (memory_s *memory) {
+  FILE *statm;
+  long  size, resident;
+
+  memory->rss = 0;
+  statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &size, &resident) == 2) {
+      memory->rss = resident * sysconf(_SC_PAGESIZE);
+    }
+    fclose(statm);
+  }
+
+  memory->allocated = mallinfo2().uordblks;
+}
+
+
+/**
+ * Connects and disconnects the Nuimo cycles times and checks that the memory stays flat
+ *
+ * @param cycles Number of connect/disconnect cycles
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_soak (unsigned int cycles) {
+  memory_s     before, after;
+  unsigned int i;
+
+  nuimo_init_ready_function(cb_ready, NULL);
+
+  for (i = 0; i < cycles + TEST_WARMUP; i++) {
+    if (i == TEST_WARMUP) {
+      get_memory(&before);
+    }
+
+    if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+      fprintf(stderr, "*EE* Cycle %u did not get ready\n", i);
+      nuimo_disconnect();
+      return(EXIT_FAILURE);
+    }
+    nuimo_disconnect();
+  }
+  get_memory(&after);
+
+  printf("soak: %u cycles, rss %ld -> %ld bytes, allocated %zu -> %zu bytes\n",
+	 cycles, before.rss, after.rss, before.allocated, after.allocated);
+
+  if (after.allocated > before.allocated + TEST_MAX_GROWTH) {
+    fprintf(stderr, "*EE* Allocations grew by %zu bytes\n", after.allocated - before.allocated);
+    return(EXIT_FAILURE);
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Checks the recovery of the watchdog (see the description at the top)
+ *
+ * @param enabled FALSE to run with the watchdog disabled
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_watchdog (gboolean enabled) {
+  struct nuimo_stats_s stats;
+  unsigned int         ready_calls  = 0;
+  unsigned int         ready_events = 0;
+
+  if (enabled) {
+    nuimo_init_watchdog(TEST_SILENCE, 0);
+  }
+  nuimo_init_ready_function(cb_count, &ready_calls);
+  nuimo_add_handler(NUIMO, NUIMO_CONNECTION_READY, cb_count_event, &ready_events);
+
+  if (nuimo_init_bt() != EXIT_SUCCESS) {
+    return(EXIT_FAILURE);
+  }
+  g_timeout_add(TEST_WATCHDOG_RUN, cb_timeout, NULL);
+  g_main_loop_run(loop);
+
+  nuimo_get_stats(&stats);
+  printf("watchdog: health %u, %u ready calls, %u READY events, %llu reconnects, %llu probes, %llu resubscribes\n",
+	 nuimo_get_health(), ready_calls, ready_events, (unsigned long long) stats.reconnects,
+	 (unsigned long long) stats.probes, (unsigned long long) stats.resubscribes);
+  nuimo_disconnect();
+
+  if (stats.reconnects != 1 || (enabled && stats.resubscribes < 1) || ready_calls != 1 || ready_events != 1) {
+    fprintf(stderr, "*EE* Unexpected recovery\n");
+    return(EXIT_FAILURE);
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Checks that the Nuimo found by the discovery is connected through the least loaded adapter
+ *
+ * @param direct TRUE for NUIMO_BUS_DIRECT mode
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_placement (gboolean direct) {
+  struct nuimo_adapter_stats_s stats[NUIMO_ADAPTERS_MAX];
+  unsigned int                 adapters, i;
+  int                          used   = -1;
+  int                          result = EXIT_SUCCESS;
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  if (direct) {
+    nuimo_init_bus_mode(NUIMO_BUS_DIRECT);
+  }
+
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  adapters = nuimo_get_adapter_stats(stats, NUIMO_ADAPTERS_MAX);
+  for (i = 0; i < adapters; i++) {
+    printf("placement: %s %u devices%s\n", stats[i].path, stats[i].devices, stats[i].in_use ? " (in use)" : "");
+    if (stats[i].in_use) {
+      used = i;
+    }
+  }
+
+  // The other adapters must not have had fewer devices than the one chosen
+  for (i = 0; i < adapters; i++) {
+    if (used < 0 || (i != (unsigned int) used && stats[i].devices < stats[used].devices - 1)) {
+      result = EXIT_FAILURE;
+    }
+  }
+  nuimo_disconnect();
+
+  if (result != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo is not connected through the least loaded adapter\n");
+  }
+
+  return(result);
+}
+
+
+/**
+ * Returns the CPU time used by the process
+ *
+ * @return User and system time in microseconds
+ */
+static gint64 get_cpu_time () {
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return((gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+
+/**
+ * Measures the wakeups and the CPU time while the Nuimo is connected
+ *
+ * @param seconds Duration of the measurement
+ * @param direct  TRUE for NUIMO_BUS_DIRECT mode
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the Nuimo did not get ready
+ */
+static int bench (unsigned int seconds, gboolean direct) {
+  struct nuimo_stats_s before, after;
+  gint64               cpu;
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  if (direct) {
+    nuimo_init_bus_mode(NUIMO_BUS_DIRECT);
+  }
+
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  nuimo_get_stats(&before);
+  cpu = get_cpu_time();
+  g_timeout_add(seconds * 1000, cb_timeout, NULL);
+  g_main_loop_run(loop);
+  cpu = get_cpu_time() - cpu;
+  nuimo_get_stats(&after);
+  nuimo_disconnect();
+
+  printf("bench %s: %.1f wakeups/s, %.2f ms CPU/s\n", direct ? "direct" : "manager",
+	 (double) (after.wakeups - before.wakeups) / seconds, (double) cpu / 1000 / seconds);
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Batch function; the delivery of the batch starts
+ *
+ * @param events    Not used
+ * @param count     Not used
+ * @param user_data Pointer to the ::dispatch_s counters
+ */
+static void cb_batch (const nuimo_event *events, unsigned int count, void *user_data) {
+  ((dispatch_s*) user_data)->mark = g_get_monotonic_time();
+}
+
+
+/**
+ * Old style callback; it is called after the handlers and the action of the event
+ *
+ * @param characteristic Not used
+ * @param value          Not used
+ * @param direction      Not used
+ * @param user_data      Pointer to the ::dispatch_s counters
+ */
+static void cb_event (unsigned int characteristic, int value, unsigned int direction, void *user_data) {
+  dispatch_s *dispatch = user_data;
+  gint64      now      = g_get_monotonic_time();
+
+  dispatch->time += now - dispatch->mark;
+  dispatch->mark  = now;
+  dispatch->events++;
+}
+
+
+/**
+ * Action function; checks the button state of the rotations. The held actions have odd arguments.
+ *
+ * @param action    Not used
+ * @param argument  Argument of the binding
+ * @param event     The event
+ * @param user_data Pointer to the ::dispatch_s counters
+ */
+static void cb_action (const char *action, int argument, const nuimo_event *event, void *user_data) {
+  dispatch_s *dispatch = user_data;
+
+  dispatch->actions++;
+  if (event->characteristic == NUIMO_ROTATION && (argument & 1) != (event->direction == NUIMO_ROTATION_LEFT)) {
+    dispatch->wrong++;
+  }
+}
+
+
+/**
+ * Runs the main loop for the given time and collects the dispatch counters
+ *
+ * @param seconds  Duration of the measurement
+ * @param dispatch Receives the counters
+ */
+static void measure_dispatch (unsigned int seconds, dispatch_s *dispatch) {
+  memset(dispatch, 0, sizeof(dispatch_s));
+  nuimo_init_batch_function(cb_batch, dispatch);
+  nuimo_init_cb_function(cb_event, dispatch);
+  nuimo_init_action_function(cb_action, dispatch);
+
+  g_timeout_add(seconds * 1000, cb_timeout, NULL);
+  g_main_loop_run(loop);
+}
+
+
+/**
+ * Checks the rejection of invalid binding configs and measures the dispatch cost (see the
+ * description at the top)
+ *
+ * @param seconds Duration of each measurement
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int bench_bindings (unsigned int seconds) {
+  dispatch_s   without, with;
+  GString     *config;
+  gint64       load_time;
+  unsigned int i, bindings;
+  int          result = EXIT_SUCCESS;
+
+  for (i = 0; TEST_INVALID[i]; i++) {
+    if (nuimo_load_bindings(TEST_INVALID[i]) == EXIT_SUCCESS) {
+      fprintf(stderr, "*EE* Invalid config %u was accepted\n", i);
+      result = EXIT_FAILURE;
+    }
+  }
+
+  // Every key once without and once with the button held
+  config = g_string_new(NULL);
+  for (i = 0, bindings = 0; TEST_KEYS[i]; i++, bindings += 2) {
+    g_string_append_printf(config, "%s action%u %u\n%s action%u_held %u held\n",
+			   TEST_KEYS[i], i, 2 * i, TEST_KEYS[i], i, 2 * i + 1);
+  }
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    g_string_free(config, TRUE);
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  nuimo_load_bindings("");
+  measure_dispatch(seconds, &without);
+
+  load_time = g_get_monotonic_time();
+  if (nuimo_load_bindings(config->str) != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The full binding table was rejected\n");
+    result = EXIT_FAILURE;
+  }
+  load_time = g_get_monotonic_time() - load_time;
+  g_string_free(config, TRUE);
+
+  measure_dispatch(seconds, &with);
+  nuimo_disconnect();
+
+  printf("bindings: %u bindings loaded in %lld us\n", bindings, (long long) load_time);
+  printf("bindings: without %u events, %.0f ns/event\n", without.events,
+	 without.events ? (double) without.time * 1000 / without.events : 0.0);
+  printf("bindings: with    %u events, %.0f ns/event, %u actions, %u wrong button state\n", with.events,
+	 with.events ? (double) with.time * 1000 / with.events : 0.0, with.actions, with.wrong);
+
+  if (!with.actions || with.actions != with.events || with.wrong) {
+    fprintf(stderr, "*EE* Unexpected actions\n");
+    result = EXIT_FAILURE;
+  }
+
+  return(result);
+}
+
+
+/**
+ * Batch function of a slow application
+ *
+ * @param events    Not used
+ * @param count     Not used
+ * @param user_data Not used
+ */
+static void cb_slow_batch (const nuimo_event *events, unsigned int count, void *user_data) {
+  g_usleep(TEST_SLOW_BATCH);
+}
+
+
+/**
+ * Other work of the application; always ready at default priority
+ *
+ * @param user_data Not used
+ * @return TRUE to keep the source
+ */
+static gboolean cb_busy (gpointer user_data) {
+  g_usleep(TEST_SLOW_BATCH / 5);
+
+  return(TRUE);
+}
+
+
+/**
+ * Checks that the button events stay fast under load (see the description at the top)
+ *
+ * @param seconds Duration of the test
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_latency (unsigned int seconds) {
+  struct nuimo_stats_s stats;
+  unsigned int         buttons = 0;
+  guint                busy;
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  nuimo_add_handler(NUIMO_BUTTON, NUIMO_BUTTON_PRESS, cb_count_event, &buttons);
+  nuimo_init_batch_function(cb_slow_batch, NULL);
+  busy = g_idle_add_full(G_PRIORITY_DEFAULT, cb_busy, NULL, NULL);
+  g_timeout_add(seconds * 1000, cb_timeout, NULL);
+  g_main_loop_run(loop);
+  g_source_remove(busy);
+
+  nuimo_get_stats(&stats);
+  nuimo_disconnect();
+
+  printf("latency: %u presses, %llu events, %llu merged, %llu batches, button latency max %lld us (bound %d us)\n",
+	 buttons, (unsigned long long) stats.events, (unsigned long long) stats.merged,
+	 (unsigned long long) stats.batches, (long long) stats.button_latency_max, TEST_MAX_BUTTON_LATENCY);
+
+  if (!buttons || stats.button_latency_max > TEST_MAX_BUTTON_LATENCY) {
+    fprintf(stderr, "*EE* The button events were delayed\n");
+    return(EXIT_FAILURE);
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Checks the deadline and the result of the teardown (see the description at the top)
+ *
+ * @param methods The methods the stand-in does not answer; NULL terminated
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_stall (char **methods) {
+  unsigned int expected = NUIMO_TEARDOWN_ALL;
+  unsigned int steps, i;
+  gint64       elapsed;
+
+  for (i = 0; methods[i]; i++) {
+    if (!strcmp(methods[i], "Disconnect")) {
+      expected &= ~NUIMO_TEARDOWN_DISCONNECT;
+    } else if (!strcmp(methods[i], "StopNotify")) {
+      expected &= ~NUIMO_MASK_ALL;
+    }
+  }
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  elapsed = g_get_monotonic_time();
+  steps   = nuimo_disconnect_deadline(TEST_STALL_DEADLINE);
+  elapsed = (g_get_monotonic_time() - elapsed) / 1000;
+
+  printf("stall: teardown took %lld ms (deadline %d ms), steps 0x%x (expected 0x%x)\n",
+	 (long long) elapsed, TEST_STALL_DEADLINE, steps, expected);
+
+  if (steps != expected || elapsed > TEST_STALL_DEADLINE + TEST_STALL_SLACK ||
+      (expected != NUIMO_TEARDOWN_ALL && elapsed < TEST_STALL_DEADLINE)) {
+    fprintf(stderr, "*EE* Unexpected teardown\n");
+    return(EXIT_FAILURE);
+  }
+
+  return(EXIT_SUCCESS);
+}
+
+
+/**
+ * Runs the main loop for the given time
+ *
+ * @param time Time in ms
+ */
+static void run_for (unsigned int time) {
+  g_timeout_add(time, cb_timeout, NULL);
+  g_main_loop_run(loop);
+}
+
+
+/**
+ * Checks the persistent display (see the description at the top)
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int test_persistent () {
+  static const unsigned char frame[11] = {0x38, 0x00, 0x0c, 0x18, 0x30, 0x60, 0x40, 0x01, 0x02, 0x04, 0x08};
+  struct nuimo_stats_s       stats;
+  guint64                    periodic, widget;
+  int                        result = EXIT_SUCCESS;
+
+  nuimo_init_ready_function(cb_ready, NULL);
+  nuimo_set_persistent(TRUE);
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+
+  // The first write shows the frame, the identical ones are redundant
+  nuimo_set_led(frame, 255, 10, 0);
+  nuimo_set_led(frame, 255, 10, 0);
+  nuimo_set_led(frame, 128, 10, 0);
+  nuimo_set_led(frame, 128, 50, 0);
+  run_for(TEST_PERIODS * TEST_PERIOD + TEST_PERIOD / 4);
+  nuimo_get_stats(&stats);
+  periodic = stats.refreshes;
+  if (stats.skipped_writes != 2 || periodic != TEST_PERIODS) {
+    result = EXIT_FAILURE;
+  }
+
+  // The widget covers the frame; the frame comes back once the widget lapsed
+  nuimo_bind_widget(NUIMO_ROTATION, NUIMO_WIDGET_BAR, 0, 100, 50, 1);
+  run_for(NUIMO_WIDGET_TIMEOUT * 100 + TEST_PERIOD / 4);
+  nuimo_get_stats(&stats);
+  widget = stats.refreshes - periodic;
+  if (widget != 1) {
+    result = EXIT_FAILURE;
+  }
+
+  // A reconnect shows the frame again as soon as the Nuimo is ready
+  nuimo_disconnect();
+  if (nuimo_init_bt() != EXIT_SUCCESS || run_until_ready() != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* The Nuimo did not get ready again\n");
+    nuimo_disconnect();
+    return(EXIT_FAILURE);
+  }
+  nuimo_get_stats(&stats);
+  nuimo_disconnect();
+
+  printf("persistent: %llu skipped writes, %llu refreshes in %d periods, %llu after the widget, %llu after the reconnect\n",
+	 (unsigned long long) stats.skipped_writes, (unsigned long long) periodic, TEST_PERIODS,
+	 (unsigned long long) widget, (unsigned long long) (stats.refreshes - periodic - widget));
+
+  if (stats.refreshes - periodic - widget != 1) {
+    result = EXIT_FAILURE;
+  }
+  if (result != EXIT_SUCCESS) {
+    fprintf(stderr, "*EE* Unexpected writes of the persistent frame\n");
+  }
+
+  return(result);
+}
+
+
+int main (int argc, char **argv) {
+  int result = EXIT_FAILURE;
+
+  if (nuimo_init_status() != EXIT_SUCCESS) {
+    return(EXIT_FAILURE);
+  }
+  loop = g_main_loop_new(NULL, FALSE);
+
+  if (argc > 2 && !strcmp(argv[1], "soak")) {
+    result = test_soak(atoi(argv[2]));
+  } else if (argc > 1 && !strcmp(argv[1], "watchdog")) {
+    result = test_watchdog(argc < 3 || strcmp(argv[2], "off"));
+  } else if (argc > 1 && !strcmp(argv[1], "placement")) {
+    result = test_placement(argc > 2 && !strcmp(argv[2], "direct"));
+  } else if (argc > 2 && !strcmp(argv[1], "bench")) {
+    result = bench(atoi(argv[2]), argc > 3 && !strcmp(argv[3], "direct"));
+  } else if (argc > 2 && !strcmp(argv[1], "latency")) {
+    result = test_latency(atoi(argv[2]));
+  } else if (argc > 1 && !strcmp(argv[1], "persistent")) {
+    result = test_persistent();
+  } else if (argc > 1 && !strcmp(argv[1], "stall")) {
+    result = test_stall(&argv[2]);
+  } else if (argc > 2 && !strcmp(argv[1], "bindings")) {
+    result = bench_bindings(atoi(argv[2]));
+  } else {
+    fprintf(stderr, "Usage: %s soak <cycles> | watchdog [off] | placement [direct] | bench <seconds> [direct] | bindings <seconds> | latency <seconds> | stall <method>... | persistent\n", argv[0]);
+  }
+
+  return(result);
+}
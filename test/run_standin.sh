@@ -0,0 +1,42 @@
+#!/bin/sh
+# Runs a command against test/bluez_standin on a private bus, so no Bluetooth hardware and no
+# system bus are needed. The stand-in options go before --, the command after it:
+#
+#   test/run_standin.sh hci0 --nuimo hci0 -- ./nuimo_test soak 1000
+
+STANDIN=$(dirname "$0")/bluez_standin
+
+if [ -z "$NUIMO_STANDIN_BUS" ]; then
+  NUIMO_STANDIN_BUS=1 exec dbus-run-session -- "$0" "$@"
+fi
+
+options=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+  options="$options $1"
+  shift
+done
+shift
+
+# The SDK and the stand-in both use the system bus
+export DBUS_SYSTEM_BUS_ADDRESS="$DBUS_SESSION_BUS_ADDRESS"
+
+$STANDIN $options &
+standin=$!
+
+tries=0
+until gdbus introspect --system --dest org.bluez --object-path / >/dev/null 2>&1; do
+  tries=$((tries + 1))
+  if [ $tries -gt 50 ]; then
+    echo "*EE* The BlueZ stand-in did not start" >&2
+    kill $standin 2>/dev/null
+    exit 1
+  fi
+  sleep 0.1
+done
+
+"$@"
+result=$?
+
+kill $standin
+wait $standin 2>/dev/null
+exit $result